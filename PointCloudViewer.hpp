@@ -17,9 +17,10 @@
  *
  * @section Point Cloud Data
  * The viewer supports adding points asynchronously via the addPoints() method.
- * Points are represented as instances of the Point structure, which holds 3D 
- * coordinates (x, y, z) and RGB color values. Point data can be read from PCD 
- * files in binary format through the readPCD() function.
+ * Points are stored as one array per channel (PointBuffers): positions, colours,
+ * intensity and classification when present, and further named attributes of any
+ * scalar type (ring, time, ...). Point data can be read from PCD files in binary
+ * format through the readPCD() function.
  *
  * @section Utility Structures & Functions
  * The following utility structures and functions are defined for ease of use:
@@ -39,19 +40,68 @@
  * - **colorPointsBasedOnDistance**: A function that colors points based on their 
  *   distance from the origin using improved gradient mapping.
  *
- * - **readPCD**: A function that reads PCD files in binary format and populates 
- *   a vector of Point structures with the data.
+ * - **readPCD**: A function that reads PCD files in binary format straight into
+ *   PointBuffers, keeping intensity, label and every other field as a typed attribute.
+ *
+ * - **MappedFile / PointBuffers**: A read-only memory mapping of a file, and point
+ *   data already laid out as the viewer's position/colour buffers, with optional
+ *   intensity, classification and named AttributeChannels. Absent channels are empty.
+ *
+ * - **readKittiBin / readKittiDrive**: Read raw KITTI velodyne scans (.bin) through
+ *   mmap, decoding in parallel chunks straight into PointBuffers and keeping the
+ *   reflectance as the intensity attribute.
+ *
+ * - **readPLY / readLAS**: Read binary (little/big endian) PLY vertices and uncompressed
+ *   LAS 1.2 - 1.4 point records (formats 0-3, 6-8) through mmap with parallel decoding,
+ *   keeping intensity and classification.
+ *
+ * - **readPointCloud**: Dispatches on the file extension to the readers above.
+ *
+ * - **writePointCloud**: Writes binary PCD, binary_compressed PCD (LZF) or binary PLY,
+ *   encoding chunks in parallel and writing them in order; exportAsync() saves the viewer's
+ *   points in the background.
+ *
+ * - **ClipRegion**: An oriented box and up to MAX_CLIP_PLANES planes tested in the point
+ *   shader; extractRegion() copies the points inside into a new cloud, skipping or copying
+ *   whole chunks by their bounds.
+ *
+ * - **EventDecimator**: Reduces a frame of events to a budget, keeping the newest event per
+ *   pixel or a random sample, in time order and with the input polarity ratio.
+ *
+ * - **readPointCloudCached**: Loads through a sidecar cache (.cpcache) in the viewer's
+ *   buffer layout, keyed by source path, size, mtime and processing options.
+ *
+ * - **GpuMemoryBudget**: Tracks the size of every GPU buffer and keeps point chunks
+ *   and tiles in an LRU resident set under a configurable byte budget.
+ *
+ * - **buildTilesFromPCD / TiledPointCloud**: Convert a PCD into an on-disk octree of
+ *   level-of-detail tiles (.cpt), and stream only the visible, screen-relevant tiles
+ *   of such a file under RAM and VRAM budgets (see openTiles()).
  *
  * @section Rendering
  * The render() function is called continuously in the main loop to update the 
  * display, including the point cloud, grid, and axes. The viewer uses OpenGL 
  * shaders for rendering, allowing for customization of visual effects.
+ * The point cloud is uploaded in chunks; only chunks inside the view frustum are
+ * made resident, and the least recently drawn ones are evicted when the GPU memory
+ * budget (setGpuMemoryBudget(), gpuMemoryStats()) is exceeded. Streamed points
+ * only re-upload the slots they wrote (glBufferSubData), and chunk buffers grow
+ * geometrically, so the upload cost of a batch follows its size.
+ * setEventTimeline() uploads a whole event recording with per-point timestamps;
+ * setTimeWindow() then only changes point shader uniforms.
+ * setRasterMode() replaces the points by a bird's-eye-view raster (DensityRaster) of
+ * per-cell density, max z or mean intensity that is binned in parallel as batches arrive;
+ * only changed cells are uploaded and the draw cost depends on the raster size alone.
+ * setViewports() splits the window into viewports with their own cameras (splitViewports()
+ * gives perspective, top and side views); the point data is brought up to date once per
+ * frame and every viewport draws the same GPU chunks.
  *
  * @section User Interaction
  * The viewer captures mouse and keyboard input for navigation and interaction:
  * - Mouse movements control camera azimuth and elevation for orbiting around the point cloud.
  * - Keyboard inputs enable panning, zooming, and toggling cursor capture mode.
  * - The R key resets the camera to its default position.
+ * - F2 toggles split viewports; mouse and keys steer the viewport under the cursor.
  *
  * @section Configuration
  * Configuration settings are defined in the Config namespace, allowing for easy 
@@ -60,8 +110,32 @@
  *
  * @section Thread Safety
  * The viewer is designed to be thread-safe when adding points and processing data. 
- * Mutexes and condition variables are used to manage concurrent access to shared 
- * resources.
+ * Batches from addPoints() reach the processing thread through a bounded lock-free
+ * ring (MpmcRing) with an EventCount wakeup; the shared point data is guarded by a
+ * mutex. ingestionLatency() reports the addPoints()-to-display latency histogram.
+ * setCapacity() bounds the stored points (FIFO eviction, decimation of old data,
+ * time-based expiry); addPoints() takes a Backpressure policy for a full ring.
+ * Several sensors feed one viewer through addSource() and addPoints(source, timestamp,
+ * points): a SourceMerger publishes their batches in timestamp order, waiting at most the
+ * reorder window (one frame), and sourceStats() reports per-source lag and drops.
+ * addPipelineStage() attaches per-batch processing (cropStage(), voxelDownsampleStage(),
+ * colormapStage(), transformStage(), outlierFilterStage() or custom stages) that runs in a
+ * TBB parallel_pipeline: batches are processed concurrently, stored in order, and at most
+ * PIPELINE_MAX_IN_FLIGHT are in flight; pipelineStats() reports per-stage counters.
+ * groundSegmentationStage() fits the ground plane of each batch by parallel RANSAC
+ * (optionally per azimuth sector) and labels (GROUND_CLASS) or strips its points;
+ * setGroundHidden() hides labelled ground with a shader uniform, without re-uploading.
+ * euclideanClusterStage() joins the points of each batch closer than a tolerance in a
+ * parallel lock-free union-find, writes cluster ids (PointBuffers::cluster) and colours,
+ * and the viewer draws the bounding boxes of the newest clusters as a line overlay.
+ * openSharedMemory() consumes frames from another process through the
+ * shared-memory ring described in SharedPointRing.hpp.
+ * startTrace() logs every point update and camera change to a binary trace
+ * (TraceRecorder) that TraceReader replays through the public API and setCamera();
+ * frameTimes() reports the render loop's frame-time histogram.
+ * loadAsync() decodes a file on a background thread and feeds it to addPoints() in
+ * chunks of LOAD_CHUNK_POINTS; the returned LoadHandle reports progress, cancels the
+ * load (also bound to Backspace) and completes a future when it ends.
  *
  * @section Cleanup
  * The destructor cleans up OpenGL resources, including buffers and shaders, and 
@@ -88,7 +162,14 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <chrono>
 #include <queue>
+#include <deque>
+#include <list>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
 #include <unordered_map>
 #include <fstream>
 #include <sstream>
@@ -97,6 +178,22 @@
 #include <algorithm> // clamp
 #include <array>
 #include <execution> // For parallel algorithms
+#include <numeric>
+#include <filesystem>
+#include <cstring>
+#include <cerrno>
+
+// POSIX memory mapping for the file readers
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Ordered, bounded parallel processing of ingested batches
+#include <tbb/parallel_pipeline.h>
+
+// Shared-memory ingestion endpoint (layout and producer library)
+#include "SharedPointRing.hpp"
 
 // Include OpenGL headers
 #ifdef __APPLE__
@@ -141,6 +238,76 @@ namespace Config {
     // Point rendering settings
     constexpr float POINT_SIZE = 5.0f;
 
+    // Loader settings
+    constexpr float COLOR_MAX_DISTANCE = 50.0f;        // Distance mapped to the end of the colour gradient
+    constexpr size_t DECODE_CHUNK_POINTS = 1 << 16;    // Points decoded per parallel task
+    constexpr size_t LOAD_CHUNK_POINTS = 1 << 18;      // Points handed to the viewer per progressive load step
+    constexpr size_t EVENT_BLOCK_EVENTS = 1 << 16;     // Events per block of a binary event file
+    constexpr size_t EVENT_CONVERT_CHUNK_BYTES = 16 << 20; // CSV slice parsed per task
+    constexpr size_t EVENT_FRAME_BUDGET = 100000;      // Events shown per display frame before decimating
+    constexpr int EVENT_DISPLAY_FPS = 60;              // Display frames per second of event playback
+    constexpr bool ENABLE_POINT_CACHE = true;          // Keep a decoded <file>.cpcache next to loaded files
+    constexpr size_t WRITE_CHUNK_POINTS = 1 << 20;     // Points encoded per parallel task when writing
+    constexpr size_t SNAPSHOT_SLICE_POINTS = 1 << 22;  // Points copied per data lock by exports and extraction
+    constexpr int SNAPSHOT_RETRIES = 2;                // Copies restarted by ingestion before one holds the lock
+
+    // Ingestion settings
+    constexpr size_t INGEST_QUEUE_CAPACITY = 1024;     // Batches queued between addPoints() and processing
+    constexpr int INGEST_SPIN_ITERATIONS = 64;         // Polls before the processing thread sleeps
+    constexpr size_t PIPELINE_MAX_IN_FLIGHT = 8;       // Batches in the processing stages at once
+    constexpr int MERGE_REORDER_WINDOW_MS = 16;        // Longest a source batch waits for older ones (one frame)
+    constexpr size_t MERGE_SOURCE_QUEUE = 64;          // Batches held per source before the oldest is dropped
+
+    // Ground segmentation settings (groundSegmentationStage())
+    constexpr float GROUND_DISTANCE_THRESHOLD = 0.2f;  // Max distance of ground points from the plane
+    constexpr float GROUND_MAX_SLOPE_DEG = 15.0f;      // Steeper planes are not ground
+    constexpr int GROUND_RANSAC_ITERATIONS = 64;       // Plane hypotheses per sector
+    constexpr size_t GROUND_SAMPLE_POINTS = 4096;      // Points scoring each hypothesis
+    constexpr uint8_t GROUND_CLASS = 2;                // ASPRS "ground" classification
+    constexpr uint8_t UNCLASSIFIED_CLASS = 1;          // ASPRS "unclassified", for newly labelled batches
+
+    // Clustering settings (euclideanClusterStage())
+    constexpr float CLUSTER_TOLERANCE = 0.5f;          // Max gap between neighbouring points of a cluster
+    constexpr size_t CLUSTER_MIN_POINTS = 10;          // Smaller clusters are noise
+
+    // Change detection settings (detectChanges())
+    constexpr float CHANGE_THRESHOLD = 0.05f;          // Closer points count as unchanged
+    constexpr float CHANGE_MAX_DISTANCE = 0.5f;        // Search radius and end of the colour ramp
+    constexpr size_t CHANGE_CHUNK_POINTS = 1 << 20;    // Points compared and handed over per chunk
+    constexpr float CHANGE_CELL_POINTS = 16.0f;         // Target reference points per index cell
+    constexpr float CHANGE_MAX_SHELLS = 4.0f;          // Cell shells searched up to max_distance
+    constexpr int SHM_POLL_INTERVAL_MS = 100;          // Retry interval while no producer exists
+    constexpr size_t SHM_CAPACITY_POINTS = 20000000;   // Points kept by --shm (FIFO eviction)
+
+    // Out-of-core tile streaming settings
+    constexpr size_t TILE_RAM_BUDGET_BYTES = size_t(2) << 30;     // Tiles cached in RAM
+    constexpr size_t TILE_UPLOAD_BYTES_PER_FRAME = 64 << 20;     // Upload limit per frame
+    constexpr size_t TILE_POINT_BUDGET = 20000000;               // Points selected per frame
+    constexpr float TILE_REFINE_PIXELS = 2.0f;                   // Refine while point spacing exceeds this
+
+    // Bird's-eye-view raster settings
+    constexpr float BEV_CELL_SIZE = 0.2f;              // Default raster cell size in metres
+    constexpr int BEV_MAX_CELLS = 4096;                // Raster cells per side (texture size limit)
+    constexpr size_t BEV_PARALLEL_POINTS = 1 << 16;    // Smaller batches are binned on one thread
+    constexpr int BEV_REBUILD_RETRIES = 2;             // Discarded background rebuilds before one runs in place
+
+    // Frame capture settings
+    constexpr size_t CAPTURE_PBO_COUNT = 3;            // Readbacks in flight before one is waited for
+    constexpr size_t CAPTURE_QUEUE_FRAMES = 8;         // Frames buffered for the encoder (power of two)
+    constexpr float CAPTURE_FPS = 30.0f;               // Fixed time step of headless rendering
+
+    // Input trace settings
+    constexpr size_t TRACE_BUFFER_BYTES = 4 << 20;     // Write buffer of a trace file
+    constexpr size_t TRACE_QUEUE_BYTES = 256 << 20;    // Encoded records waiting for the trace writer
+
+    // GPU memory settings
+    constexpr size_t GPU_MEMORY_BUDGET_BYTES = size_t(2) << 30;  // All evictable point buffers
+    constexpr size_t GPU_CHUNK_POINTS = 1 << 20;                 // Points per GPU chunk
+
+    // Clipping settings (setClipRegion())
+    constexpr size_t MAX_CLIP_PLANES = 6;               // Clip planes evaluated by the point shader
+    constexpr float CLIP_BOX_SIZE = 20.0f;              // Edge length of a new interactive clip box
+
     // Supported Data Fields
     constexpr std::array<const char*, 5> SUPPORTED_FIELDS = { "x", "y", "z", "rgb", "rgba" };
 }
@@ -211,215 +378,4857 @@ inline void HSVtoRGB(float h, float s, float v, uint8_t& r, uint8_t& g, uint8_t&
     b = static_cast<uint8_t>(std::round(b_f * 255));
 }
 
+// Map the distance of a position from the origin onto the red-to-blue gradient
+inline void distanceToRGB(float x, float y, float z, float max_distance, uint8_t& r, uint8_t& g, uint8_t& b) {
+    // Calculate the Euclidean distance from the origin
+    float distance = std::sqrt(x * x + y * y + z * z);
+
+    // Normalize the distance with respect to the maximum distance
+    float t_norm = std::min(distance / max_distance, 1.0f);  // Clamp between 0 and 1
+
+    // Map the normalized distance to a hue value (0 to 0.66 for red to blue)
+    float hue = (1.0f - t_norm) * 0.66f; // 0.0 = red, 0.66 = blue
+    float saturation = 1.0f; // Full saturation
+    float value = 1.0f; // Full brightness
+
+    // Convert HSV to RGB
+    HSVtoRGB(hue, saturation, value, r, g, b);
+}
+
 // Function to color points based on distance with improved gradient mapping
 inline  void colorPointsBasedOnDistance(std::vector<Point>& points, float max_distance) {
     // Using parallel execution to color points efficiently
     std::for_each(std::execution::par, points.begin(), points.end(),
         [&](Point& point) {
-            // Calculate the Euclidean distance from the origin
-            float distance = std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z);
+            distanceToRGB(point.x, point.y, point.z, max_distance, point.r, point.g, point.b);
+        }
+    );
+}
+
+// Read-only memory mapping of a whole file (POSIX: Linux and macOS)
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename) { open(filename); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    bool open(const std::string& filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps its own reference to the file
+        if (ptr == MAP_FAILED) return false;
+        data_ = static_cast<const uint8_t*>(ptr);
+        size_ = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // Hint the kernel to read ahead aggressively; readers touch every page once
+    void adviseSequential() const {
+        if (data_) madvise(const_cast<uint8_t*>(data_), size_, MADV_SEQUENTIAL | MADV_WILLNEED);
+    }
+
+    bool isOpen() const { return data_ != nullptr; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Byte-order helpers for the binary readers
+inline bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+template <typename T>
+inline T loadScalar(const uint8_t* ptr, bool swap_bytes) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, ptr, sizeof(T));
+    if (swap_bytes) std::reverse(bytes, bytes + sizeof(T));
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// Scalar types of point attributes (and of PLY properties)
+enum class AttributeType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+inline size_t attributeTypeSize(AttributeType type) {
+    switch (type) {
+        case AttributeType::Int8: case AttributeType::UInt8: return 1;
+        case AttributeType::Int16: case AttributeType::UInt16: return 2;
+        case AttributeType::Int32: case AttributeType::UInt32: case AttributeType::Float32: return 4;
+        case AttributeType::Float64: return 8;
+        default: return 0;
+    }
+}
+
+inline double loadAttributeScalar(const uint8_t* ptr, AttributeType type, bool swap_bytes) {
+    switch (type) {
+        case AttributeType::Int8: return static_cast<int8_t>(*ptr);
+        case AttributeType::UInt8: return *ptr;
+        case AttributeType::Int16: return loadScalar<int16_t>(ptr, swap_bytes);
+        case AttributeType::UInt16: return loadScalar<uint16_t>(ptr, swap_bytes);
+        case AttributeType::Int32: return loadScalar<int32_t>(ptr, swap_bytes);
+        case AttributeType::UInt32: return loadScalar<uint32_t>(ptr, swap_bytes);
+        case AttributeType::Float32: return loadScalar<float>(ptr, swap_bytes);
+        case AttributeType::Float64: return loadScalar<double>(ptr, swap_bytes);
+        default: return 0.0;
+    }
+}
+
+// A named per-point channel of one scalar type (e.g. ring, time, label), stored packed in
+// native byte order
+struct AttributeChannel {
+    std::string name;
+    AttributeType type = AttributeType::Float32;
+    std::vector<uint8_t> bytes;             // size() * elementSize() bytes
+
+    size_t elementSize() const { return attributeTypeSize(type); }
+    size_t size() const { return bytes.size() / elementSize(); }
+    double value(size_t i) const { return loadAttributeScalar(&bytes[i * elementSize()], type, false); }
+
+    // Copy count values from src_index of another channel of the same type to dst_index
+    void copyFrom(const AttributeChannel& src, size_t src_index, size_t dst_index, size_t count) {
+        size_t width = elementSize();
+        std::memcpy(&bytes[dst_index * width], &src.bytes[src_index * width], count * width);
+    }
+};
+
+// Point data in the viewer's buffer layout (x,y,z positions and r,g,b colours in [0,1]),
+// plus the per-point intensity and classification when the source provides them and any
+// further named attributes. Absent channels are empty and cost no memory.
+struct PointBuffers {
+    std::vector<float> positions;           // x, y, z
+    std::vector<float> colors;              // r, g, b
+    std::vector<float> intensity;           // Empty if the source has no intensity channel
+    std::vector<uint8_t> classification;    // Empty if the source has no classification channel
+    std::vector<uint32_t> cluster;          // Cluster id per point (0 = none), empty if not clustered
+    std::vector<AttributeChannel> attributes; // Further channels, one value per point each
+    double origin[3] = {0.0, 0.0, 0.0};     // World position of the local (0,0,0)
+
+    size_t size() const { return positions.size() / 3; }
+    bool empty() const { return positions.empty(); }
+
+    void resize(size_t count, bool with_intensity, bool with_classification = false) {
+        positions.resize(count * 3);
+        colors.resize(count * 3);
+        intensity.resize(with_intensity ? count : 0);
+        classification.resize(with_classification ? count : 0);
+        for (AttributeChannel& channel : attributes) channel.bytes.resize(count * channel.elementSize());
+    }
+
+    // Add a zero-filled attribute channel sized to the points
+    AttributeChannel& addAttribute(const std::string& name, AttributeType type) {
+        AttributeChannel& channel = attributes.emplace_back();
+        channel.name = name;
+        channel.type = type;
+        channel.bytes.resize(size() * channel.elementSize());
+        return channel;
+    }
+
+    const AttributeChannel* attribute(const std::string& name) const {
+        for (const AttributeChannel& channel : attributes)
+            if (channel.name == name) return &channel;
+        return nullptr;
+    }
+
+    // Every present channel holds exactly one value per point
+    bool consistent() const {
+        size_t count = size();
+        if (positions.size() != count * 3) return false;
+        if (!colors.empty() && colors.size() != count * 3) return false;
+        if (!intensity.empty() && intensity.size() != count) return false;
+        if (!classification.empty() && classification.size() != count) return false;
+        if (!cluster.empty() && cluster.size() != count) return false;
+        for (const AttributeChannel& channel : attributes)
+            if (channel.bytes.size() != count * channel.elementSize()) return false;
+        return true;
+    }
+
+    // Copy of the points [first, first + count) with all their channels
+    PointBuffers slice(size_t first, size_t count) const {
+        PointBuffers out;
+        for (const AttributeChannel& channel : attributes) out.attributes.push_back({ channel.name, channel.type, {} });
+        out.resize(count, !intensity.empty(), !classification.empty());
+        std::copy_n(positions.begin() + first * 3, count * 3, out.positions.begin());
+        if (!colors.empty()) std::copy_n(colors.begin() + first * 3, count * 3, out.colors.begin());
+        else out.colors.clear();
+        if (!intensity.empty()) std::copy_n(intensity.begin() + first, count, out.intensity.begin());
+        if (!classification.empty()) std::copy_n(classification.begin() + first, count, out.classification.begin());
+        if (!cluster.empty()) out.cluster.assign(cluster.begin() + first, cluster.begin() + first + count);
+        for (size_t a = 0; a < attributes.size(); ++a) out.attributes[a].copyFrom(attributes[a], first, 0, count);
+        std::copy(origin, origin + 3, out.origin);
+        return out;
+    }
+};
+
+// Non-owning view of points in the buffer layout (null for absent channels; the viewer
+// colours points by distance when colors is null)
+struct PointView {
+    const float* positions = nullptr;
+    const float* colors = nullptr;
+    const float* intensity = nullptr;
+    const uint8_t* classification = nullptr;
+    const uint32_t* cluster = nullptr;
+    const std::vector<AttributeChannel>* attributes = nullptr; // Indexed like positions
+    const double* origin = nullptr;         // World position of the local (0,0,0), null if at 0
+    size_t count = 0;
+
+    PointView() = default;
+    PointView(const PointBuffers& points) :
+        positions(points.positions.data()),
+        colors(points.colors.empty() ? nullptr : points.colors.data()),
+        intensity(points.intensity.empty() ? nullptr : points.intensity.data()),
+        classification(points.classification.empty() ? nullptr : points.classification.data()),
+        cluster(points.cluster.empty() ? nullptr : points.cluster.data()),
+        attributes(points.attributes.empty() ? nullptr : &points.attributes),
+        origin(points.origin[0] != 0.0 || points.origin[1] != 0.0 || points.origin[2] != 0.0 ? points.origin : nullptr),
+        count(points.size()) {}
+
+    const AttributeChannel* attribute(const std::string& name, AttributeType type) const {
+        if (attributes)
+            for (const AttributeChannel& channel : *attributes)
+                if (channel.name == name && channel.type == type) return &channel;
+        return nullptr;
+    }
+
+    const AttributeChannel* attribute(const std::string& name) const {
+        if (attributes)
+            for (const AttributeChannel& channel : *attributes)
+                if (channel.name == name) return &channel;
+        return nullptr;
+    }
+};
+
+// Run fn(begin, end) over [0, count) split into fixed-size chunks, in parallel
+template <typename Fn>
+inline void parallelForChunks(size_t count, size_t chunk_size, Fn&& fn) {
+    if (count == 0) return;
+    std::vector<size_t> chunks((count + chunk_size - 1) / chunk_size);
+    std::iota(chunks.begin(), chunks.end(), size_t{0});
+    std::for_each(std::execution::par, chunks.begin(), chunks.end(),
+        [&](size_t c) {
+            size_t begin = c * chunk_size;
+            fn(begin, std::min(begin + chunk_size, count));
+        }
+    );
+}
+
+// Decode raw KITTI velodyne records (float32 x, y, z, reflectance) into buffers at a point offset
+inline void decodeKittiRecords(const uint8_t* records, size_t count, PointBuffers& out, size_t offset) {
+    parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float rec[4];
+            std::memcpy(rec, records + i * sizeof(rec), sizeof(rec));
+            size_t o = offset + i;
+            out.positions[o * 3 + 0] = rec[0];
+            out.positions[o * 3 + 1] = rec[1];
+            out.positions[o * 3 + 2] = rec[2];
+            out.intensity[o] = rec[3];
+
+            uint8_t r, g, b;
+            distanceToRGB(rec[0], rec[1], rec[2], Config::COLOR_MAX_DISTANCE, r, g, b);
+            out.colors[o * 3 + 0] = r / 255.0f;
+            out.colors[o * 3 + 1] = g / 255.0f;
+            out.colors[o * 3 + 2] = b / 255.0f;
+        }
+    });
+}
+
+// Function to read a raw KITTI velodyne scan (.bin, float32 x, y, z, reflectance per point)
+inline bool readKittiBin(const std::string& filename, PointBuffers& points) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Error: Could not map KITTI file: " << filename << '\n';
+        return false;
+    }
+    constexpr size_t record_size = 4 * sizeof(float);
+    if (file.size() % record_size != 0) {
+        std::cerr << "Error: KITTI file size is not a multiple of " << record_size << " bytes: " << filename << '\n';
+        return false;
+    }
+    file.adviseSequential();
 
-            // Normalize the distance with respect to the maximum distance
-            float t_norm = std::min(distance / max_distance, 1.0f);  // Clamp between 0 and 1
+    size_t count = file.size() / record_size;
+    points.resize(count, true);
+    decodeKittiRecords(file.data(), count, points, 0);
 
-            // Map the normalized distance to a hue value (0 to 0.66 for red to blue)
-            float hue = (1.0f - t_norm) * 0.66f; // 0.0 = red, 0.66 = blue
-            float saturation = 1.0f; // Full saturation
-            float value = 1.0f; // Full brightness
+    std::cout << "Successfully read " << count << " points from " << filename << '\n';
+    return true;
+}
+
+// Function to read every scan of a KITTI drive (a directory of velodyne .bin files) into one cloud.
+// Files are mapped and decoded concurrently, each into its own slice of the output buffers.
+inline bool readKittiDrive(const std::string& directory, PointBuffers& points) {
+    namespace fs = std::filesystem;
+    constexpr size_t record_size = 4 * sizeof(float);
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".bin")
+            files.push_back(entry.path());
+    }
+    if (ec || files.empty()) {
+        std::cerr << "Error: No KITTI .bin scans found in " << directory << '\n';
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    // Map all scans up front so the output can be sized and sliced before decoding
+    std::vector<MappedFile> maps(files.size());
+    std::vector<size_t> offsets(files.size() + 1, 0);
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!maps[i].open(files[i].string()) || maps[i].size() % record_size != 0) {
+            std::cerr << "Error: Invalid KITTI scan: " << files[i] << '\n';
+            return false;
+        }
+        maps[i].adviseSequential();
+        offsets[i + 1] = offsets[i] + maps[i].size() / record_size;
+    }
 
-            // Convert HSV to RGB
-            HSVtoRGB(hue, saturation, value, point.r, point.g, point.b);
+    points.resize(offsets.back(), true);
+    std::vector<size_t> indices(files.size());
+    std::iota(indices.begin(), indices.end(), size_t{0});
+    std::for_each(std::execution::par, indices.begin(), indices.end(),
+        [&](size_t i) {
+            decodeKittiRecords(maps[i].data(), offsets[i + 1] - offsets[i], points, offsets[i]);
         }
     );
+
+    std::cout << "Successfully read " << points.size() << " points from " << files.size()
+              << " scans in " << directory << '\n';
+    return true;
 }
 
-// Function to read PCD file (supports "DATA binary" format only)
-inline bool readPCD(const std::string& filename, std::vector<Point>& points) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        std::cerr << "Error: Could not open file; Make sure file is correct and the pcd is binary format!" << filename << '\n';
+inline AttributeType parsePlyType(const std::string& name) {
+    if (name == "char" || name == "int8") return AttributeType::Int8;
+    if (name == "uchar" || name == "uint8") return AttributeType::UInt8;
+    if (name == "short" || name == "int16") return AttributeType::Int16;
+    if (name == "ushort" || name == "uint16") return AttributeType::UInt16;
+    if (name == "int" || name == "int32") return AttributeType::Int32;
+    if (name == "uint" || name == "uint32") return AttributeType::UInt32;
+    if (name == "float" || name == "float32") return AttributeType::Float32;
+    if (name == "double" || name == "float64") return AttributeType::Float64;
+    return AttributeType::Invalid;
+}
+
+// Function to read the vertex element of a binary (little or big endian) PLY file
+inline bool readPLY(const std::string& filename, PointBuffers& points) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Error: Could not map PLY file: " << filename << '\n';
         return false;
     }
 
-    std::string line;
-    bool dataSectionFound = false;
-    size_t pointCount = 0;
-    size_t width = 0, height = 0;
-    std::vector<std::string> fields;
-    std::unordered_map<std::string, size_t> fieldIndices;
+    // The header is ASCII and ends with "end_header\n"
+    const char* text = reinterpret_cast<const char*>(file.data());
+    const char* text_end = text + file.size();
+    static const char end_marker[] = "end_header";
+    const char* marker = std::search(text, text_end, end_marker, end_marker + sizeof(end_marker) - 1);
+    const char* body = marker == text_end ? text_end : std::find(marker, text_end, '\n');
+    if (file.size() < 3 || std::strncmp(text, "ply", 3) != 0 || body == text_end) {
+        std::cerr << "Error: Not a PLY file or header is incomplete: " << filename << '\n';
+        return false;
+    }
+    std::istringstream header(std::string(text, body));
+    size_t data_offset = static_cast<size_t>(body + 1 - text);
 
-    // Parse header
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
+    struct Property { std::string name; AttributeType type; size_t offset; };
+    std::vector<Property> properties;
+    bool swap_bytes = false;
+    bool in_vertex = false, vertex_seen = false;
+    size_t vertex_count = 0, stride = 0, skip_bytes = 0;
+    size_t element_count = 0, element_stride = 0;
 
+    std::string line;
+    while (std::getline(header, line)) {
         std::istringstream iss(line);
         std::string key;
         iss >> key;
+        if (key == "format") {
+            std::string format;
+            iss >> format;
+            if (format == "binary_little_endian") swap_bytes = !hostIsLittleEndian();
+            else if (format == "binary_big_endian") swap_bytes = hostIsLittleEndian();
+            else {
+                std::cerr << "Error: Only binary PLY files are supported.\n";
+                return false;
+            }
+        }
+        else if (key == "element") {
+            // Fixed-size elements that precede the vertices are skipped over
+            if (!vertex_seen) skip_bytes += element_count * element_stride;
+            std::string name;
+            iss >> name >> element_count;
+            element_stride = 0;
+            in_vertex = (name == "vertex");
+            if (in_vertex) {
+                vertex_seen = true;
+                vertex_count = element_count;
+            }
+        }
+        else if (key == "property") {
+            std::string type_name, name;
+            iss >> type_name >> name;
+            if (type_name == "list") {
+                if (in_vertex || !vertex_seen) {
+                    std::cerr << "Error: PLY list properties before or inside the vertex element are not supported.\n";
+                    return false;
+                }
+                continue;
+            }
+            AttributeType type = parsePlyType(type_name);
+            if (type == AttributeType::Invalid) {
+                std::cerr << "Error: Unknown PLY property type: " << type_name << '\n';
+                return false;
+            }
+            if (in_vertex) properties.push_back({name, type, stride});
+            element_stride += attributeTypeSize(type);
+            if (in_vertex) stride = element_stride;
+        }
+    }
+
+    auto findProperty = [&](std::initializer_list<const char*> names) -> const Property* {
+        for (const char* n : names)
+            for (const auto& p : properties)
+                if (p.name == n) return &p;
+        return nullptr;
+    };
+    const Property* px = findProperty({"x"});
+    const Property* py = findProperty({"y"});
+    const Property* pz = findProperty({"z"});
+    const Property* pr = findProperty({"red", "r", "diffuse_red"});
+    const Property* pg = findProperty({"green", "g", "diffuse_green"});
+    const Property* pb = findProperty({"blue", "b", "diffuse_blue"});
+    const Property* pi = findProperty({"intensity", "scalar_intensity", "scalar_Intensity", "reflectance"});
+    const Property* pc = findProperty({"classification", "scalar_classification", "scalar_Classification", "label"});
+    if (!px || !py || !pz) {
+        std::cerr << "Error: PLY vertex element must contain x, y, z properties.\n";
+        return false;
+    }
+    bool has_rgb = pr && pg && pb;
+
+    data_offset += skip_bytes;
+    if (data_offset + vertex_count * stride > file.size()) {
+        std::cerr << "Error: Unexpected end of file while reading PLY vertices.\n";
+        return false;
+    }
+    file.adviseSequential();
+
+    // Colour channels are normalized by the range of their integer type
+    auto colorScale = [](AttributeType type) {
+        switch (type) {
+            case AttributeType::UInt16: case AttributeType::Int16: return 1.0f / 65535.0f;
+            case AttributeType::Float32: case AttributeType::Float64: return 1.0f;
+            default: return 1.0f / 255.0f;
+        }
+    };
+    float color_scale = has_rgb ? colorScale(pr->type) : 1.0f;
+
+    // Every other property becomes a named attribute of its own type
+    std::vector<const Property*> extra;
+    for (const auto& p : properties)
+        if (&p != px && &p != py && &p != pz && &p != pi && &p != pc && !(has_rgb && (&p == pr || &p == pg || &p == pb)))
+            extra.push_back(&p);
+
+    points.attributes.clear();
+    points.resize(vertex_count, pi != nullptr, pc != nullptr);
+    for (const Property* p : extra) points.addAttribute(p->name, p->type);
+    const uint8_t* base = file.data() + data_offset;
+    parallelForChunks(vertex_count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t* rec = base + i * stride;
+            float x = static_cast<float>(loadAttributeScalar(rec + px->offset, px->type, swap_bytes));
+            float y = static_cast<float>(loadAttributeScalar(rec + py->offset, py->type, swap_bytes));
+            float z = static_cast<float>(loadAttributeScalar(rec + pz->offset, pz->type, swap_bytes));
+            points.positions[i * 3 + 0] = x;
+            points.positions[i * 3 + 1] = y;
+            points.positions[i * 3 + 2] = z;
+
+            if (has_rgb) {
+                points.colors[i * 3 + 0] = static_cast<float>(loadAttributeScalar(rec + pr->offset, pr->type, swap_bytes)) * color_scale;
+                points.colors[i * 3 + 1] = static_cast<float>(loadAttributeScalar(rec + pg->offset, pg->type, swap_bytes)) * color_scale;
+                points.colors[i * 3 + 2] = static_cast<float>(loadAttributeScalar(rec + pb->offset, pb->type, swap_bytes)) * color_scale;
+            } else {
+                uint8_t r, g, b;
+                distanceToRGB(x, y, z, Config::COLOR_MAX_DISTANCE, r, g, b);
+                points.colors[i * 3 + 0] = r / 255.0f;
+                points.colors[i * 3 + 1] = g / 255.0f;
+                points.colors[i * 3 + 2] = b / 255.0f;
+            }
+            if (pi) points.intensity[i] = static_cast<float>(loadAttributeScalar(rec + pi->offset, pi->type, swap_bytes));
+            if (pc) points.classification[i] = static_cast<uint8_t>(loadAttributeScalar(rec + pc->offset, pc->type, swap_bytes));
+            for (size_t a = 0; a < extra.size(); ++a) {
+                uint8_t* value = &points.attributes[a].bytes[i * attributeTypeSize(extra[a]->type)];
+                std::memcpy(value, rec + extra[a]->offset, attributeTypeSize(extra[a]->type));
+                if (swap_bytes) std::reverse(value, value + attributeTypeSize(extra[a]->type));
+            }
+        }
+    });
+
+    std::cout << "Successfully read " << vertex_count << " points from " << filename << '\n';
+    return true;
+}
+
+// Function to read an uncompressed LAS 1.2 - 1.4 file (point data record formats 0-3 and 6-8).
+// Scale and offset are applied in double precision; positions are stored relative to the
+// minimum corner of the header bounds (PointBuffers::origin) to keep float precision.
+inline bool readLAS(const std::string& filename, PointBuffers& points) {
+    MappedFile file(filename);
+    if (!file.isOpen() || file.size() < 227 || std::memcmp(file.data(), "LASF", 4) != 0) {
+        std::cerr << "Error: Could not map LAS file or bad signature: " << filename << '\n';
+        return false;
+    }
+    const uint8_t* h = file.data();
+    const bool swap_bytes = !hostIsLittleEndian(); // LAS is always little endian
+
+    uint8_t version_minor = h[25];
+    uint16_t header_size = loadScalar<uint16_t>(h + 94, swap_bytes);
+    uint32_t point_offset = loadScalar<uint32_t>(h + 96, swap_bytes);
+    uint8_t format_id = h[104];
+    uint16_t record_length = loadScalar<uint16_t>(h + 105, swap_bytes);
+    uint64_t point_count = loadScalar<uint32_t>(h + 107, swap_bytes);
+    if (version_minor >= 4 && header_size >= 255 && file.size() >= 255)
+        point_count = std::max<uint64_t>(point_count, loadScalar<uint64_t>(h + 247, swap_bytes));
+
+    if (format_id & 0xC0) {
+        std::cerr << "Error: Compressed (LAZ) point data is not supported.\n";
+        return false;
+    }
+    format_id &= 0x3F;
+
+    // Field offsets within a record for the supported point data formats
+    size_t min_length = 0, intensity_at = 12, class_at = 0, rgb_at = 0, time_at = 0;
+    uint8_t class_mask = 0xFF;
+    bool has_rgb = false;
+    switch (format_id) {
+        case 0: min_length = 20; class_at = 15; class_mask = 0x1F; break;
+        case 1: min_length = 28; class_at = 15; class_mask = 0x1F; time_at = 20; break;
+        case 2: min_length = 26; class_at = 15; class_mask = 0x1F; rgb_at = 20; has_rgb = true; break;
+        case 3: min_length = 34; class_at = 15; class_mask = 0x1F; rgb_at = 28; has_rgb = true; time_at = 20; break;
+        case 6: min_length = 30; class_at = 16; time_at = 22; break;
+        case 7: min_length = 36; class_at = 16; rgb_at = 30; has_rgb = true; time_at = 22; break;
+        case 8: min_length = 38; class_at = 16; rgb_at = 30; has_rgb = true; time_at = 22; break;
+        default:
+            std::cerr << "Error: Unsupported LAS point data record format " << int(format_id) << ".\n";
+            return false;
+    }
+    if (record_length < min_length || point_offset + point_count * record_length > file.size()) {
+        std::cerr << "Error: LAS record layout does not match the file size.\n";
+        return false;
+    }
+
+    double scale[3], offset[3];
+    for (int a = 0; a < 3; ++a) {
+        scale[a] = loadScalar<double>(h + 131 + a * 8, swap_bytes);
+        offset[a] = loadScalar<double>(h + 155 + a * 8, swap_bytes);
+    }
+    double min_bound[3] = {
+        loadScalar<double>(h + 187, swap_bytes),
+        loadScalar<double>(h + 203, swap_bytes),
+        loadScalar<double>(h + 219, swap_bytes)
+    };
+    double max_z = loadScalar<double>(h + 211, swap_bytes);
+    double z_range = std::max(max_z - min_bound[2], 1e-6);
+    file.adviseSequential();
+
+    // The spec asks for 16-bit colour, but many writers store 8-bit values: if no channel
+    // exceeds 255 anywhere, scale by 255 instead of 65535
+    const uint8_t* base = file.data() + point_offset;
+    float rgb_scale = 1.0f / 65535.0f;
+    if (has_rgb) {
+        std::atomic<bool> wide{false};
+        parallelForChunks(point_count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+            uint16_t max_value = 0;
+            for (size_t i = begin; i < end; ++i)
+                for (int c = 0; c < 3; ++c)
+                    max_value = std::max(max_value, loadScalar<uint16_t>(base + i * record_length + rgb_at + c * 2, swap_bytes));
+            if (max_value > 255) wide.store(true, std::memory_order_relaxed);
+        });
+        if (!wide) rgb_scale = 1.0f / 255.0f;
+    }
+
+    points.attributes.clear();
+    points.resize(point_count, true, true);
+    uint8_t* gps_time = time_at ? points.addAttribute("gps_time", AttributeType::Float64).bytes.data() : nullptr;
+    std::copy(min_bound, min_bound + 3, points.origin);
+    parallelForChunks(point_count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t* rec = base + i * record_length;
+            for (int a = 0; a < 3; ++a) {
+                double v = loadScalar<int32_t>(rec + a * 4, swap_bytes) * scale[a] + offset[a];
+                points.positions[i * 3 + a] = static_cast<float>(v - min_bound[a]);
+            }
+            points.intensity[i] = loadScalar<uint16_t>(rec + intensity_at, swap_bytes);
+            points.classification[i] = rec[class_at] & class_mask;
+            if (gps_time) {
+                double t = loadScalar<double>(rec + time_at, swap_bytes);
+                std::memcpy(gps_time + i * sizeof(t), &t, sizeof(t));
+            }
+
+            if (has_rgb) {
+                for (int c = 0; c < 3; ++c)
+                    points.colors[i * 3 + c] = loadScalar<uint16_t>(rec + rgb_at + c * 2, swap_bytes) * rgb_scale;
+            } else {
+                // No colour in the file: map height within the header bounds onto the gradient
+                float t_norm = std::clamp(static_cast<float>(points.positions[i * 3 + 2] / z_range), 0.0f, 1.0f);
+                uint8_t r, g, b;
+                HSVtoRGB((1.0f - t_norm) * 0.66f, 1.0f, 1.0f, r, g, b);
+                points.colors[i * 3 + 0] = r / 255.0f;
+                points.colors[i * 3 + 1] = g / 255.0f;
+                points.colors[i * 3 + 2] = b / 255.0f;
+            }
+        }
+    });
+
+    std::cout << "Successfully read " << point_count << " points from " << filename << '\n';
+    return true;
+}
+
+// Field layout of a binary PCD file, parsed from a mapped file without copying the data
+struct PcdLayout {
+    struct Field { std::string name; AttributeType type; size_t offset; };
+
+    size_t point_count = 0;
+    size_t stride = 0;          // Bytes per point record
+    size_t data_offset = 0;     // Byte offset of the first record
+    int x_offset = -1, y_offset = -1, z_offset = -1, rgb_offset = -1; // Byte offsets within a record
+    AttributeType position_type = AttributeType::Float32;
+    int intensity_offset = -1, classification_offset = -1;
+    AttributeType intensity_type = AttributeType::Float32, classification_type = AttributeType::UInt32;
+    std::vector<Field> attributes; // Further single-value fields, read as named attributes
+};
 
+// Attribute type of a PCD field from its TYPE (I, U or F) and SIZE; 64-bit integers are Invalid
+inline AttributeType pcdFieldType(char type, size_t size) {
+    if (type == 'F') return size == 4 ? AttributeType::Float32 : size == 8 ? AttributeType::Float64 : AttributeType::Invalid;
+    bool is_signed = type == 'I';
+    switch (size) {
+        case 1: return is_signed ? AttributeType::Int8 : AttributeType::UInt8;
+        case 2: return is_signed ? AttributeType::Int16 : AttributeType::UInt16;
+        case 4: return is_signed ? AttributeType::Int32 : AttributeType::UInt32;
+        default: return AttributeType::Invalid;
+    }
+}
+
+// Function to parse the header of a mapped binary PCD file (honours SIZE, TYPE and COUNT)
+inline bool parsePCDLayout(const MappedFile& file, PcdLayout& layout) {
+    const char* text = reinterpret_cast<const char*>(file.data());
+    const char* end = text + file.size();
+    const char* line_begin = text;
+    std::vector<std::string> fields;
+    std::vector<size_t> sizes, counts;
+    std::vector<char> types;
+    size_t width = 0, height = 0;
+
+    while (line_begin < end) {
+        const char* line_end = std::find(line_begin, end, '\n');
+        std::istringstream iss(std::string(line_begin, line_end));
+        line_begin = line_end + 1;
+        std::string key;
+        iss >> key;
         if (key == "FIELDS") {
             fields.assign(std::istream_iterator<std::string>(iss), std::istream_iterator<std::string>());
-            for (size_t i = 0; i < fields.size(); ++i) {
-                fieldIndices[fields[i]] = i;
-            }
         }
-        else if (key == "POINTS") {
-            iss >> pointCount;
+        else if (key == "SIZE") {
+            sizes.assign(std::istream_iterator<size_t>(iss), std::istream_iterator<size_t>());
         }
-        else if (key == "WIDTH") {
-            iss >> width;
+        else if (key == "TYPE") {
+            types.assign(std::istream_iterator<char>(iss), std::istream_iterator<char>());
         }
-        else if (key == "HEIGHT") {
-            iss >> height;
+        else if (key == "COUNT") {
+            counts.assign(std::istream_iterator<size_t>(iss), std::istream_iterator<size_t>());
         }
+        else if (key == "POINTS") iss >> layout.point_count;
+        else if (key == "WIDTH") iss >> width;
+        else if (key == "HEIGHT") iss >> height;
         else if (key == "DATA") {
-            if (line.find(Constants::DATA_BINARY_PREFIX) != std::string::npos) {
-                dataSectionFound = true;
-                break;
-            } else {
+            std::string format;
+            iss >> format;
+            if (format != Constants::DATA_BINARY_PREFIX) {
                 std::cerr << "Error: Only 'binary' DATA format is supported.\n";
                 return false;
             }
+            layout.data_offset = static_cast<size_t>(line_begin - text);
+            break;
         }
     }
-
-    if (!dataSectionFound) {
+    if (layout.data_offset == 0) {
         std::cerr << "Error: 'DATA binary' not found in the PCD file header.\n";
         return false;
     }
-
-    if (pointCount == 0) {
-        if (width * height == 0) {
-            std::cerr << "Error: Number of points not specified in the PCD header.\n";
-            return false;
-        }
-        pointCount = width * height;
-    }
-
-    if (fields.size() < 3) {
-        std::cerr << "Error: PCD file must contain at least x, y, z fields.\n";
+    if (layout.point_count == 0) layout.point_count = width * height;
+    if (sizes.empty()) sizes.assign(fields.size(), sizeof(float));
+    if (counts.empty()) counts.assign(fields.size(), 1);
+    if (types.empty()) types.assign(fields.size(), 'F');
+    if (sizes.size() != fields.size() || counts.size() != fields.size() || types.size() != fields.size()) {
+        std::cerr << "Error: PCD FIELDS, SIZE, TYPE and COUNT lengths differ.\n";
         return false;
     }
 
-    // Determine indices for required fields
-    size_t x_idx, y_idx, z_idx, rgb_idx = SIZE_MAX;
-    try {
-        x_idx = fieldIndices.at(Constants::SUPPORTED_FIELD_X);
-        y_idx = fieldIndices.at(Constants::SUPPORTED_FIELD_Y);
-        z_idx = fieldIndices.at(Constants::SUPPORTED_FIELD_Z);
+    AttributeType axis_types[3] = { AttributeType::Invalid, AttributeType::Invalid, AttributeType::Invalid };
+    for (size_t f = 0; f < fields.size(); ++f) {
+        int offset = static_cast<int>(layout.stride);
+        AttributeType type = counts[f] == 1 ? pcdFieldType(types[f], sizes[f]) : AttributeType::Invalid;
+        if (fields[f] == Constants::SUPPORTED_FIELD_X) { layout.x_offset = offset; axis_types[0] = type; }
+        else if (fields[f] == Constants::SUPPORTED_FIELD_Y) { layout.y_offset = offset; axis_types[1] = type; }
+        else if (fields[f] == Constants::SUPPORTED_FIELD_Z) { layout.z_offset = offset; axis_types[2] = type; }
+        else if (fields[f] == Constants::SUPPORTED_FIELD_RGB || fields[f] == Constants::SUPPORTED_FIELD_RGBA) {
+            if (sizes[f] == 4) layout.rgb_offset = offset;
+        }
+        else if (fields[f] == "intensity" && type != AttributeType::Invalid) {
+            layout.intensity_offset = offset;
+            layout.intensity_type = type;
+        }
+        else if ((fields[f] == "label" || fields[f] == "classification") && type != AttributeType::Invalid) {
+            layout.classification_offset = offset; // Like readPLY(); labels above 255 wrap
+            layout.classification_type = type;
+        }
+        else if (fields[f] != "_" && type != AttributeType::Invalid) {
+            // Padding ("_"), multi-value and 64-bit integer fields are skipped
+            layout.attributes.push_back({ fields[f], type, layout.stride });
+        }
+        layout.stride += sizes[f] * counts[f];
     }
-    catch (const std::out_of_range&) {
+    if (layout.x_offset < 0 || layout.y_offset < 0 || layout.z_offset < 0) {
         std::cerr << "Error: PCD file must contain x, y, z fields.\n";
         return false;
     }
-
-    // Check for RGB fields
-    bool hasRGB = false;
-    if (fieldIndices.find(Constants::SUPPORTED_FIELD_RGB) != fieldIndices.end()) {
-        hasRGB = true;
-        rgb_idx = fieldIndices.at(Constants::SUPPORTED_FIELD_RGB);
-    }
-    else if (fieldIndices.find(Constants::SUPPORTED_FIELD_RGBA) != fieldIndices.end()) {
-        hasRGB = true;
-        rgb_idx = fieldIndices.at(Constants::SUPPORTED_FIELD_RGBA);
+    layout.position_type = axis_types[0];
+    if (axis_types[1] != axis_types[0] || axis_types[2] != axis_types[0] ||
+        (axis_types[0] != AttributeType::Float32 && axis_types[0] != AttributeType::Float64)) {
+        std::cerr << "Error: PCD x, y, z fields must all be float or all be double.\n";
+        return false;
     }
-
-    // Calculate point size
-    size_t pointSize = fields.size() * sizeof(float);
-
-    // Read binary data
-    std::vector<char> binaryData(pointCount * pointSize);
-    file.read(binaryData.data(), binaryData.size());
-    if (static_cast<size_t>(file.gcount()) != binaryData.size()) {
+    if (layout.data_offset + layout.point_count * layout.stride > file.size()) {
         std::cerr << "Error: Unexpected end of file while reading point data.\n";
         return false;
     }
+    return true;
+}
 
-    // Parse binary data into points
-    points.reserve(pointCount);
-    const char* ptr = binaryData.data();
-    for (size_t i = 0; i < pointCount; ++i) {
-        Point p;
-        uint32_t rgbInt = 0;
-        for (size_t f = 0; f < fields.size(); ++f) {
-            float value = *reinterpret_cast<const float*>(ptr);
-            ptr += sizeof(float);
-            if (f == x_idx) p.x = value;
-            else if (f == y_idx) p.y = value;
-            else if (f == z_idx) p.z = value;
-            else if (hasRGB && f == rgb_idx) rgbInt = *reinterpret_cast<const uint32_t*>(&value);
+// Decode the records [first, first + count) of a mapped binary PCD straight into the channels:
+// positions, rgb/rgba colours, intensity, label and every further field as a named attribute.
+// Without rgb the colours are left empty (the viewer colours by distance); an rgb of 0, the
+// placeholder many writers leave in uncoloured clouds, is shown white.
+inline void decodePCDRecords(const MappedFile& file, const PcdLayout& layout, size_t first, size_t count, PointBuffers& out) {
+    out.positions.resize(count * 3);
+    out.colors.resize(layout.rgb_offset >= 0 ? count * 3 : 0);
+    out.intensity.resize(layout.intensity_offset >= 0 ? count : 0);
+    out.classification.resize(layout.classification_offset >= 0 ? count : 0);
+    out.attributes.clear();
+    for (const PcdLayout::Field& field : layout.attributes) out.addAttribute(field.name, field.type);
+
+    const int axis_offsets[3] = { layout.x_offset, layout.y_offset, layout.z_offset };
+    const bool float_positions = layout.position_type == AttributeType::Float32;
+    const bool float_intensity = layout.intensity_type == AttributeType::Float32;
+    const uint8_t* data = file.data() + layout.data_offset + first * layout.stride;
+    parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t* record = data + i * layout.stride;
+            for (int a = 0; a < 3; ++a) {
+                if (float_positions) std::memcpy(&out.positions[i * 3 + a], record + axis_offsets[a], sizeof(float));
+                else out.positions[i * 3 + a] = static_cast<float>(loadScalar<double>(record + axis_offsets[a], false));
+            }
+            if (layout.rgb_offset >= 0) {
+                uint32_t rgb;
+                std::memcpy(&rgb, record + layout.rgb_offset, sizeof(rgb));
+                if ((rgb & 0xFFFFFF) == 0) rgb = 0xFFFFFF; // Black placeholder: default to white
+                out.colors[i * 3 + 0] = ((rgb >> 16) & 0xFF) / 255.0f;
+                out.colors[i * 3 + 1] = ((rgb >> 8) & 0xFF) / 255.0f;
+                out.colors[i * 3 + 2] = (rgb & 0xFF) / 255.0f;
+            }
+            if (layout.intensity_offset >= 0) {
+                const uint8_t* value = record + layout.intensity_offset;
+                if (float_intensity) std::memcpy(&out.intensity[i], value, sizeof(float));
+                else out.intensity[i] = static_cast<float>(loadAttributeScalar(value, layout.intensity_type, false));
+            }
+            if (layout.classification_offset >= 0) {
+                double label = loadAttributeScalar(record + layout.classification_offset, layout.classification_type, false);
+                out.classification[i] = static_cast<uint8_t>(static_cast<int64_t>(label));
+            }
+            for (size_t a = 0; a < layout.attributes.size(); ++a) {
+                AttributeChannel& channel = out.attributes[a];
+                std::memcpy(&channel.bytes[i * channel.elementSize()], record + layout.attributes[a].offset, channel.elementSize());
+            }
         }
+    });
+}
 
-        if (hasRGB) {
-            p.r = (rgbInt >> 16) & 0xFF;
-            p.g = (rgbInt >> 8) & 0xFF;
-            p.b = rgbInt & 0xFF;
-            // Assign default color if black
-            if (p.r == 0 && p.g == 0 && p.b == 0) {
-                p.r = p.g = p.b = 255;
+// Function to read a binary PCD file into the buffer channels; points without rgb/rgba are
+// coloured by distance
+inline bool readPCD(const std::string& filename, PointBuffers& points) {
+    MappedFile file(filename);
+    PcdLayout layout;
+    if (!file.isOpen()) {
+        std::cerr << "Error: Could not open file; Make sure file is correct and the pcd is binary format!" << filename << '\n';
+        return false;
+    }
+    if (!parsePCDLayout(file, layout)) return false;
+    file.adviseSequential();
+    decodePCDRecords(file, layout, 0, layout.point_count, points);
+    if (points.colors.empty()) {
+        points.colors.resize(layout.point_count * 3);
+        parallelForChunks(layout.point_count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const float* p = &points.positions[i * 3];
+                uint8_t r, g, b;
+                distanceToRGB(p[0], p[1], p[2], Config::COLOR_MAX_DISTANCE, r, g, b);
+                points.colors[i * 3 + 0] = r / 255.0f;
+                points.colors[i * 3 + 1] = g / 255.0f;
+                points.colors[i * 3 + 2] = b / 255.0f;
             }
-        }
-        points.emplace_back(p);
+        });
     }
-
     std::cout << "Successfully read " << points.size() << " points from " << filename << '\n';
     return true;
 }
 
 
+// Lower-case file extension including the dot (e.g. ".pcd")
+inline std::string fileExtension(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+// Function to read any supported point cloud file (or a KITTI drive directory) into PointBuffers
+inline bool readPointCloud(const std::string& path, PointBuffers& points) {
+    std::string ext = fileExtension(path);
+    if (std::filesystem::is_directory(path)) return readKittiDrive(path, points);
+    if (ext == ".bin") return readKittiBin(path, points);
+    if (ext == ".ply") return readPLY(path, points);
+    if (ext == ".las") return readLAS(path, points);
+    if (ext == ".pcd") return readPCD(path, points);
+    std::cerr << "Error: Unsupported point cloud format: " << path << '\n';
+    return false;
+}
 
-// Simple 4x4 Matrix structure for transformations
-struct Matrix4x4 {
-    std::array<float, 16> data = {
-        1.0f, 0.0f, 0.0f, 0.0f, 
-        0.0f, 1.0f, 0.0f, 0.0f, 
-        0.0f, 0.0f, 1.0f, 0.0f, 
-        0.0f, 0.0f, 0.0f, 1.0f
-    };
+// Whether readPointCloud() can open the given path
+inline bool isPointCloudPath(const std::string& path) {
+    std::string ext = fileExtension(path);
+    return std::filesystem::is_directory(path) || ext == ".pcd" || ext == ".bin" || ext == ".ply" || ext == ".las";
+}
 
-    static Matrix4x4 identity() {
-    Matrix4x4 mat;
-        mat.data = {
-            1.0f, 0.0f, 0.0f, 0.0f, 
-            0.0f, 1.0f, 0.0f, 0.0f, 
-            0.0f, 0.0f, 1.0f, 0.0f, 
-            0.0f, 0.0f, 0.0f, 1.0f
-        };
-        return mat;
+// ==========================
+// Preprocessed Point Cache
+// ==========================
+//
+// A sidecar file (<source>.cpcache) holding a decoded, coloured cloud in the viewer's buffer
+// layout, so later launches skip parsing, colouring and conversion:
+//
+//   PointCacheHeader                      at offset 0 (128 bytes)
+//   float positions[3 * point_count]
+//   float colors[3 * point_count]
+//   float intensity[point_count]          if flags & POINT_CACHE_INTENSITY
+//   uint8_t classification[point_count]   if flags & POINT_CACHE_CLASSIFICATION
+//   per attribute (header.attribute_count):
+//     uint8_t type, uint8_t name_length, char name[name_length]
+//     values[point_count]                 packed, of the attribute's type
+//
+// The cache is valid only for the same source path, size and modification time, and the
+// same processing options (options_hash).
+
+struct PointCacheHeader {
+    char magic[8];              // "CPCACHE\0"
+    uint32_t version;
+    uint32_t flags;
+    uint64_t point_count;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t path_hash;
+    uint64_t options_hash;
+    double origin[3];
+    uint32_t attribute_count;
+    uint8_t reserved[44];
+};
+static_assert(sizeof(PointCacheHeader) == 128, "PointCacheHeader layout is part of the file format");
+
+constexpr char POINT_CACHE_MAGIC[8] = { 'C', 'P', 'C', 'A', 'C', 'H', 'E', '\0' };
+constexpr uint32_t POINT_CACHE_VERSION = 3; // 3: black PCD rgb placeholders decode white
+constexpr uint32_t POINT_CACHE_INTENSITY = 1u << 0;
+constexpr uint32_t POINT_CACHE_CLASSIFICATION = 1u << 1;
+
+// 64-bit FNV-1a hash
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
     }
-    
-    // Matrix multiplication (Column-Major)
-    Matrix4x4 operator*(const Matrix4x4& other) const {
-        Matrix4x4 result;
-        for(int row=0; row<4; ++row)
-            for(int col=0; col<4; ++col) {
-                result.data[col*4 + row] = 0.0f;
-                for(int k=0; k<4; ++k)
-                    result.data[col*4 + row] += data[k*4 + row] * other.data[col*4 + k];
-            }
-        return result;
+    return hash;
+}
+
+// Hash of every option that changes what the readers produce
+inline uint64_t pointCacheOptionsHash() {
+    float max_distance = Config::COLOR_MAX_DISTANCE;
+    return fnv1a64(&max_distance, sizeof(max_distance));
+}
+
+// Expected cache header for a source file (magic, version and key fields filled)
+inline bool pointCacheKey(const std::string& source, PointCacheHeader& key) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path canonical = fs::canonical(source, ec);
+    if (ec || !fs::is_regular_file(canonical, ec)) return false;
+
+    key = {};
+    std::memcpy(key.magic, POINT_CACHE_MAGIC, sizeof(key.magic));
+    key.version = POINT_CACHE_VERSION;
+    key.source_size = fs::file_size(canonical, ec);
+    key.source_mtime = static_cast<int64_t>(fs::last_write_time(canonical, ec).time_since_epoch().count());
+    std::string path = canonical.string();
+    key.path_hash = fnv1a64(path.data(), path.size());
+    key.options_hash = pointCacheOptionsHash();
+    return !ec;
+}
+
+inline std::string pointCachePath(const std::string& source) {
+    return source + ".cpcache";
+}
+
+// Unique name for a temporary file next to target, so concurrent writers (two viewers loading
+// the same source) never write into the same file before renaming it over the target
+inline std::string temporaryPath(const std::string& target) {
+    static std::atomic<uint64_t> counter{0};
+    return target + "." + std::to_string(::getpid()) + "." + std::to_string(counter++) + ".tmp";
+}
+
+// Function to read a cache file if it matches the key. The mapped blocks are copied into the
+// buffers in bulk; no per-point work is done. The copy is deliberate: PointBuffers owns its
+// storage (it is moved into the viewer's ring), and the mapping is closed on return, so one
+// sequential memcpy per block is the cheapest way out of the page cache.
+inline bool readPointCache(const std::string& cache_filename, const PointCacheHeader& key, PointBuffers& points) {
+    MappedFile file(cache_filename);
+    if (!file.isOpen() || file.size() < sizeof(PointCacheHeader)) return false;
+    PointCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, key.magic, sizeof(header.magic)) != 0 || header.version != key.version ||
+        header.source_size != key.source_size || header.source_mtime != key.source_mtime ||
+        header.path_hash != key.path_hash || header.options_hash != key.options_hash)
+        return false;
+
+    size_t n = header.point_count;
+    bool has_intensity = header.flags & POINT_CACHE_INTENSITY;
+    bool has_classification = header.flags & POINT_CACHE_CLASSIFICATION;
+    size_t fixed = sizeof(header) + n * 6 * sizeof(float) + (has_intensity ? n * sizeof(float) : 0) + (has_classification ? n : 0);
+    if (file.size() < fixed) return false;
+    file.adviseSequential();
+
+    const float* positions = reinterpret_cast<const float*>(file.data() + sizeof(header));
+    const float* colors = positions + n * 3;
+    const float* intensity = colors + n * 3;
+    const uint8_t* classification = reinterpret_cast<const uint8_t*>(has_intensity ? intensity + n : intensity);
+    points.positions.assign(positions, positions + n * 3);
+    points.colors.assign(colors, colors + n * 3);
+    if (has_intensity) points.intensity.assign(intensity, intensity + n);
+    else points.intensity.clear();
+    if (has_classification) points.classification.assign(classification, classification + n);
+    else points.classification.clear();
+
+    points.attributes.clear();
+    size_t at = fixed;
+    for (uint32_t a = 0; a < header.attribute_count; ++a) {
+        if (at + 2 > file.size()) return false;
+        AttributeType type = static_cast<AttributeType>(file.data()[at]);
+        size_t name_length = file.data()[at + 1];
+        if (attributeTypeSize(type) == 0 || at + 2 + name_length + n * attributeTypeSize(type) > file.size()) return false;
+        std::string name(reinterpret_cast<const char*>(file.data() + at + 2), name_length);
+        at += 2 + name_length;
+        AttributeChannel& channel = points.addAttribute(name, type);
+        std::copy_n(file.data() + at, channel.bytes.size(), channel.bytes.begin());
+        at += channel.bytes.size();
     }
-};
+    if (at != file.size()) return false;
+    std::copy(header.origin, header.origin + 3, points.origin);
+    return true;
+}
 
-// Forward declaration of PointCloudViewer for callbacks
-class PointCloudViewer;
+// Function to write a cache file with large sequential writes (via a temporary file and rename)
+inline bool writePointCache(const std::string& cache_filename, const PointCacheHeader& key, const PointBuffers& points) {
+    PointCacheHeader header = key;
+    header.point_count = points.size();
+    header.flags = (points.intensity.empty() ? 0 : POINT_CACHE_INTENSITY) |
+                   (points.classification.empty() ? 0 : POINT_CACHE_CLASSIFICATION);
+    header.attribute_count = static_cast<uint32_t>(points.attributes.size());
+    std::copy(points.origin, points.origin + 3, header.origin);
 
-// ==========================
-// PointCloudViewer Class
-// ==========================
-class PointCloudViewer {
-public:
-    // Constructor with parameters
-    PointCloudViewer(int width = Config::WINDOW_WIDTH, int height = Config::WINDOW_HEIGHT, const char* title = Config::WINDOW_TITLE) :
-        width_(width), height_(height), title_(title), window_(nullptr),
-        vbo_(0), vao_(0), color_vbo_(0), shader_program_(0),
-        grid_vbo_(0), grid_vao_(0), axes_vbo_(0), axes_vao_(0),
-        target_{0.0f, 0.0f, 0.0f},
-        distance_(Config::INITIAL_DISTANCE),
-        azimuth_(Config::INITIAL_AZIMUTH), elevation_(Config::INITIAL_ELEVATION),
-        pan_x_(0.0f), pan_y_(0.0f),
-        last_x_(static_cast<float>(width_) / 2.0f), last_y_(static_cast<float>(height_) / 2.0f),
-        first_mouse_(true),
-        fov_(Config::INITIAL_FOV),
+    std::string tmp = temporaryPath(cache_filename);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(points.positions.data()), points.positions.size() * sizeof(float));
+        out.write(reinterpret_cast<const char*>(points.colors.data()), points.colors.size() * sizeof(float));
+        out.write(reinterpret_cast<const char*>(points.intensity.data()), points.intensity.size() * sizeof(float));
+        out.write(reinterpret_cast<const char*>(points.classification.data()), points.classification.size());
+        for (const AttributeChannel& channel : points.attributes) {
+            uint8_t tag[2] = { static_cast<uint8_t>(channel.type), static_cast<uint8_t>(std::min<size_t>(channel.name.size(), 255)) };
+            out.write(reinterpret_cast<const char*>(tag), sizeof(tag));
+            out.write(channel.name.data(), tag[1]);
+            out.write(reinterpret_cast<const char*>(channel.bytes.data()), channel.bytes.size());
+        }
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), cache_filename.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Function to read a point cloud through its sidecar cache: a valid cache is loaded directly,
+// otherwise the source is decoded and the cache (re)written. cache_hit reports which happened.
+// With cache_write, a miss writes the cache on a background thread from a copy of the points,
+// so the caller can hand them on (e.g. to setPoints) at once and wait for the future later.
+inline bool readPointCloudCached(const std::string& path, PointBuffers& points, bool* cache_hit = nullptr,
+                                 std::future<bool>* cache_write = nullptr) {
+    if (cache_hit) *cache_hit = false;
+    PointCacheHeader key;
+    if (!Config::ENABLE_POINT_CACHE || !pointCacheKey(path, key))
+        return readPointCloud(path, points); // Directories and unreadable paths are not cached
+
+    std::string cache_filename = pointCachePath(path);
+    if (readPointCache(cache_filename, key, points)) {
+        if (cache_hit) *cache_hit = true;
+        std::cout << "Read " << points.size() << " points from cache " << cache_filename << '\n';
+        return true;
+    }
+    if (!readPointCloud(path, points))
+        return false;
+    auto write = [cache_filename, key](const PointBuffers& cached) {
+        bool ok = writePointCache(cache_filename, key, cached);
+        if (!ok) std::cerr << "Warning: Could not write point cache " << cache_filename << '\n';
+        return ok;
+    };
+    if (cache_write)
+        *cache_write = std::async(std::launch::async, [write, copy = points]() { return write(copy); });
+    else
+        write(points);
+    return true;
+}
+
+
+// ==========================
+// Progressive Loading
+// ==========================
+
+// Progress and control of an asynchronous load or export (see PointCloudViewer::loadAsync(),
+// exportAsync())
+class LoadHandle {
+public:
+    // Fraction of the input decoded so far (0..1)
+    float progress() const {
+        uint64_t total = total_.load(std::memory_order_relaxed);
+        return total ? static_cast<float>(done_.load(std::memory_order_relaxed)) / total : 0.0f;
+    }
+    uint64_t pointsLoaded() const { return points_.load(std::memory_order_relaxed); }
+
+    // Stop after the chunk being decoded; points already handed over are kept
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+    // Becomes true once every point was handed over, false if the load failed or was cancelled
+    std::shared_future<bool> completion() const { return completion_; }
+
+    // Loader side
+    void setTotal(uint64_t units) { total_.store(units, std::memory_order_relaxed); }
+    void advance(uint64_t units, uint64_t points) {
+        done_.fetch_add(units, std::memory_order_relaxed);
+        points_.fetch_add(points, std::memory_order_relaxed);
+    }
+    void finish(bool ok) { promise_.set_value(ok && !isCancelled()); }
+
+private:
+    std::atomic<uint64_t> total_{0}, done_{0}, points_{0};
+    std::atomic<bool> cancelled_{false};
+    std::promise<bool> promise_;
+    std::shared_future<bool> completion_ = promise_.get_future().share();
+};
+
+using PointSink = std::function<void(PointBuffers&&)>;
+
+// Hand KITTI records over in chunks of LOAD_CHUNK_POINTS
+inline bool streamKittiFile(const std::string& filename, LoadHandle& handle, const PointSink& sink) {
+    constexpr size_t record_size = 4 * sizeof(float);
+    MappedFile file(filename);
+    if (!file.isOpen() || file.size() % record_size != 0) {
+        std::cerr << "Error: Invalid KITTI scan: " << filename << '\n';
+        return false;
+    }
+    file.adviseSequential();
+    size_t count = file.size() / record_size;
+    for (size_t first = 0; first < count && !handle.isCancelled(); first += Config::LOAD_CHUNK_POINTS) {
+        size_t n = std::min(Config::LOAD_CHUNK_POINTS, count - first);
+        PointBuffers chunk;
+        chunk.resize(n, true);
+        decodeKittiRecords(file.data() + first * record_size, n, chunk, 0);
+        sink(std::move(chunk));
+        handle.advance(n * record_size, n);
+    }
+    return true;
+}
+
+// Decode a point cloud in chunks and hand each to sink as soon as it is decoded, so the first
+// points can be shown long before a large file is read. Binary PCD files, KITTI scans and
+// KITTI drives stream; PLY and LAS files are decoded whole and then handed over in chunks.
+// Returns false on errors or when the handle was cancelled.
+inline bool streamPointCloud(const std::string& path, LoadHandle& handle, const PointSink& sink) {
+    namespace fs = std::filesystem;
+    std::string ext = fileExtension(path);
+
+    if (ext == ".pcd") {
+        MappedFile file(path);
+        PcdLayout layout;
+        if (!file.isOpen() || !parsePCDLayout(file, layout)) {
+            std::cerr << "Error: Could not open PCD file: " << path << '\n';
+            return false;
+        }
+        file.adviseSequential();
+        handle.setTotal(layout.point_count);
+        for (size_t first = 0; first < layout.point_count && !handle.isCancelled(); first += Config::LOAD_CHUNK_POINTS) {
+            size_t n = std::min(Config::LOAD_CHUNK_POINTS, layout.point_count - first);
+            PointBuffers chunk;
+            decodePCDRecords(file, layout, first, n, chunk);
+            sink(std::move(chunk));
+            handle.advance(n, n);
+        }
+        return !handle.isCancelled();
+    }
+
+    std::error_code ec;
+    if (ext == ".bin" || fs::is_directory(path, ec)) {
+        std::vector<fs::path> files;
+        if (ext == ".bin") {
+            files.push_back(path);
+        } else {
+            for (const auto& entry : fs::directory_iterator(path, ec))
+                if (entry.is_regular_file(ec) && entry.path().extension() == ".bin")
+                    files.push_back(entry.path());
+            std::sort(files.begin(), files.end());
+        }
+        uint64_t total = 0;
+        for (const auto& f : files) {
+            uint64_t size = fs::file_size(f, ec);
+            if (ec) {
+                std::cerr << "Error: Could not read " << f.string() << ": " << ec.message() << '\n';
+                return false;
+            }
+            total += size;
+        }
+        handle.setTotal(total);
+        for (const auto& f : files) {
+            if (handle.isCancelled() || !streamKittiFile(f.string(), handle, sink))
+                return false;
+        }
+        return !files.empty() && !handle.isCancelled();
+    }
+
+    PointBuffers points;
+    handle.setTotal(1);
+    if (!readPointCloud(path, points) || handle.isCancelled())
+        return false;
+    size_t count = points.size();
+    for (size_t first = 0; first < count && !handle.isCancelled(); first += Config::LOAD_CHUNK_POINTS) {
+        size_t n = std::min(Config::LOAD_CHUNK_POINTS, count - first);
+        sink(points.slice(first, n));
+        handle.advance(0, n);
+    }
+    handle.advance(1, 0);
+    return !handle.isCancelled();
+}
+
+// ==========================
+// Point Cloud Writers
+// ==========================
+//
+// Binary PCD (uncompressed, or binary_compressed: the fields one after another, LZF
+// compressed) and binary PLY. Chunks of WRITE_CHUNK_POINTS are encoded in parallel while
+// finished chunks are written in order, so the file is written with large sequential writes.
+// Fields: x, y, z, colour, and intensity, classification and further attributes when the
+// points have them. Points with an origin (LAS) are written at their world positions as
+// doubles, so exports keep their georeference.
+
+enum class PointFileFormat {
+    PcdBinary,
+    PcdBinaryCompressed,
+    PlyBinary
+};
+
+// Format for a file name: .ply is PLY, anything else binary PCD
+inline PointFileFormat pointFileFormat(const std::string& path) {
+    return fileExtension(path) == ".ply" ? PointFileFormat::PlyBinary : PointFileFormat::PcdBinary;
+}
+
+// Compress in into out in the LZF format (liblzf compatible). out needs lzfBound(size)
+// bytes. Independently compressed blocks can be concatenated: back references never reach
+// before the start of their block, so the result decompresses as one stream.
+inline size_t lzfBound(size_t size) {
+    return size + size / 32 + 1;
+}
+
+inline size_t lzfCompress(const uint8_t* in, size_t size, uint8_t* out) {
+    constexpr int HASH_BITS = 14;
+    constexpr size_t MAX_OFFSET = 1 << 13, MAX_LITERAL = 32, MAX_MATCH = 264;
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // Last position + 1 of each hash
+    size_t ip = 0, op = 1, literal = 0; // out[op - literal - 1] holds the open literal run's length
+
+    auto endLiteral = [&]() {
+        if (literal) out[op - literal - 1] = static_cast<uint8_t>(literal - 1);
+        else --op; // Drop the unused length byte
+    };
+    while (ip + 2 < size) {
+        uint32_t v = (uint32_t(in[ip]) << 16) | (uint32_t(in[ip + 1]) << 8) | in[ip + 2];
+        uint32_t h = (v * 2654435761u) >> (32 - HASH_BITS);
+        size_t ref = table[h];
+        table[h] = static_cast<uint32_t>(ip + 1);
+        if (ref-- && ip - ref <= MAX_OFFSET && in[ref] == in[ip] && in[ref + 1] == in[ip + 1] && in[ref + 2] == in[ip + 2]) {
+            size_t length = 3, max_length = std::min(MAX_MATCH, size - ip);
+            while (length < max_length && in[ref + length] == in[ip + length]) ++length;
+            endLiteral();
+            size_t offset = ip - ref - 1, code = length - 2;
+            if (code < 7) {
+                out[op++] = static_cast<uint8_t>((offset >> 8) + (code << 5));
+            } else {
+                out[op++] = static_cast<uint8_t>((offset >> 8) + (7 << 5));
+                out[op++] = static_cast<uint8_t>(code - 7);
+            }
+            out[op++] = static_cast<uint8_t>(offset);
+            out[op++] = 0; // Length byte of the next literal run
+            literal = 0;
+            ip += length;
+            continue;
+        }
+        out[op++] = in[ip++];
+        if (++literal == MAX_LITERAL) {
+            endLiteral();
+            out[op++] = 0;
+            literal = 0;
+        }
+    }
+    while (ip < size) {
+        out[op++] = in[ip++];
+        if (++literal == MAX_LITERAL && ip < size) {
+            endLiteral();
+            out[op++] = 0;
+            literal = 0;
+        }
+    }
+    endLiteral();
+    return op;
+}
+
+// Encode chunks in parallel and append them to out in order. encode(chunk, bytes) fills the
+// bytes of one chunk and returns the points it completed; handle (optional) tracks the
+// chunks written and cancels.
+template <typename Encode>
+inline bool writeEncodedChunks(std::ofstream& out, size_t chunks, LoadHandle* handle, Encode&& encode) {
+    struct Chunk { size_t index; size_t points; std::vector<uint8_t> bytes; };
+    if (handle) handle->setTotal(chunks);
+    size_t next = 0;
+    bool ok = true;
+    tbb::parallel_pipeline(Config::PIPELINE_MAX_IN_FLIGHT,
+        tbb::make_filter<void, Chunk*>(tbb::filter_mode::serial_in_order,
+            [&](tbb::flow_control& control) -> Chunk* {
+                if (next == chunks || !ok || (handle && handle->isCancelled())) {
+                    control.stop();
+                    return nullptr;
+                }
+                return new Chunk{ next++, 0, {} };
+            }) &
+        tbb::make_filter<Chunk*, Chunk*>(tbb::filter_mode::parallel,
+            [&](Chunk* chunk) {
+                chunk->points = encode(chunk->index, chunk->bytes);
+                return chunk;
+            }) &
+        tbb::make_filter<Chunk*, void>(tbb::filter_mode::serial_in_order,
+            [&](Chunk* raw) {
+                std::unique_ptr<Chunk> chunk(raw);
+                out.write(reinterpret_cast<const char*>(chunk->bytes.data()), chunk->bytes.size());
+                ok = ok && static_cast<bool>(out);
+                if (handle) handle->advance(1, chunk->points);
+            }));
+    return ok && !(handle && handle->isCancelled());
+}
+
+// Function to write points as binary PCD, binary_compressed PCD or binary PLY (via a
+// temporary file and rename). Cancelling through handle leaves no file behind.
+inline bool writePointCloud(const std::string& filename, const PointView& points, PointFileFormat format,
+                            LoadHandle* handle = nullptr) {
+    const size_t count = points.count;
+    const bool has_intensity = points.intensity != nullptr;
+    const bool has_class = points.classification != nullptr;
+    static const std::vector<AttributeChannel> no_attributes;
+    const std::vector<AttributeChannel>& attributes = points.attributes ? *points.attributes : no_attributes;
+    const size_t position_size = points.origin ? sizeof(double) : sizeof(float);
+
+    // Coordinate a of point i into out: float as stored, or the double world position
+    auto position = [&](size_t i, int a, uint8_t* out) {
+        if (points.origin) {
+            double world = points.origin[a] + points.positions[i * 3 + a];
+            std::memcpy(out, &world, sizeof(world));
+        } else {
+            std::memcpy(out, &points.positions[i * 3 + a], sizeof(float));
+        }
+    };
+    // Colour as 8-bit RGB (white without colours)
+    auto rgb = [&](size_t i, uint8_t c[3]) {
+        for (int k = 0; k < 3; ++k)
+            c[k] = points.colors ? static_cast<uint8_t>(std::clamp(points.colors[i * 3 + k], 0.0f, 1.0f) * 255.0f + 0.5f) : 255;
+    };
+    // PCD fields: x, y, z (position_size each), rgb packed as 0x00RRGGBB, intensity and label
+    // (4 bytes each), then the attributes (field Attribute + a) at their own size
+    enum PcdField { X, Y, Z, Rgb, Intensity, Label, Attribute };
+    std::vector<size_t> pcd_fields = { X, Y, Z, Rgb };
+    if (has_intensity) pcd_fields.push_back(Intensity);
+    if (has_class) pcd_fields.push_back(Label);
+    for (size_t a = 0; a < attributes.size(); ++a) pcd_fields.push_back(Attribute + a);
+    auto fieldSize = [&](size_t field) {
+        return field >= Attribute ? attributes[field - Attribute].elementSize() : field <= Z ? position_size : 4;
+    };
+    auto pcdValue = [&](size_t field, size_t i, uint8_t* out) {
+        uint32_t value;
+        if (field >= Attribute) {
+            const AttributeChannel& channel = attributes[field - Attribute];
+            std::memcpy(out, &channel.bytes[i * channel.elementSize()], channel.elementSize());
+            return;
+        } else if (field <= Z) {
+            position(i, static_cast<int>(field), out);
+            return;
+        } else if (field == Rgb) {
+            uint8_t c[3];
+            rgb(i, c);
+            value = (uint32_t(c[0]) << 16) | (uint32_t(c[1]) << 8) | c[2];
+        } else if (field == Intensity) {
+            std::memcpy(&value, &points.intensity[i], 4);
+        } else {
+            value = points.classification[i];
+        }
+        std::memcpy(out, &value, 4);
+    };
+    size_t record_size = 0;
+    for (size_t field : pcd_fields) record_size += fieldSize(field);
+
+    // Type names of the attributes in PLY and PCD headers
+    auto plyTypeName = [](AttributeType type) {
+        static const char* names[] = { "char", "uchar", "short", "ushort", "int", "uint", "float", "double" };
+        return names[static_cast<int>(type)];
+    };
+    auto pcdTypeCode = [](AttributeType type) {
+        return type == AttributeType::Float32 || type == AttributeType::Float64 ? 'F' :
+               type == AttributeType::Int8 || type == AttributeType::Int16 || type == AttributeType::Int32 ? 'I' : 'U';
+    };
+
+    std::ostringstream header;
+    if (format == PointFileFormat::PlyBinary) {
+        header << "ply\nformat " << (hostIsLittleEndian() ? "binary_little_endian" : "binary_big_endian") << " 1.0\n"
+               << "element vertex " << count << "\n"
+               << (points.origin ? "property double x\nproperty double y\nproperty double z\n"
+                                 : "property float x\nproperty float y\nproperty float z\n")
+               << "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+        if (has_intensity) header << "property float intensity\n";
+        if (has_class) header << "property uchar classification\n";
+        for (const AttributeChannel& channel : attributes)
+            header << "property " << plyTypeName(channel.type) << " " << channel.name << "\n";
+        header << "end_header\n";
+    } else {
+        std::string names, sizes, types, counts;
+        for (const AttributeChannel& channel : attributes) {
+            names += " " + channel.name;
+            sizes += " " + std::to_string(channel.elementSize());
+            types += std::string(" ") + pcdTypeCode(channel.type);
+            counts += " 1";
+        }
+        header << "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\n"
+               << "FIELDS x y z rgb" << (has_intensity ? " intensity" : "") << (has_class ? " label" : "") << names << "\n"
+               << "SIZE " << position_size << " " << position_size << " " << position_size << " 4" << (has_intensity ? " 4" : "") << (has_class ? " 4" : "") << sizes << "\n"
+               << "TYPE F F F U" << (has_intensity ? " F" : "") << (has_class ? " U" : "") << types << "\n"
+               << "COUNT 1 1 1 1" << (has_intensity ? " 1" : "") << (has_class ? " 1" : "") << counts << "\n"
+               << "WIDTH " << count << "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS " << count << "\n"
+               << "DATA " << (format == PointFileFormat::PcdBinaryCompressed ? "binary_compressed" : "binary") << "\n";
+    }
+
+    std::string tmp = temporaryPath(filename); // Concurrent exports to one path do not share it
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Could not create " << filename << std::endl;
+        return false;
+    }
+    std::string text = header.str();
+    out.write(text.data(), text.size());
+
+    const size_t chunk_points = Config::WRITE_CHUNK_POINTS;
+    const size_t chunks = (count + chunk_points - 1) / chunk_points;
+    auto range = [&](size_t chunk, size_t& begin, size_t& end) {
+        begin = chunk * chunk_points;
+        end = std::min(begin + chunk_points, count);
+    };
+    bool ok;
+    if (format == PointFileFormat::PlyBinary) {
+        const size_t xyz = 3 * position_size;
+        const size_t base_stride = xyz + 3 + (has_intensity ? 4 : 0) + (has_class ? 1 : 0);
+        size_t stride = base_stride;
+        for (const AttributeChannel& channel : attributes) stride += channel.elementSize();
+        ok = writeEncodedChunks(out, chunks, handle, [&](size_t chunk, std::vector<uint8_t>& bytes) {
+            size_t begin, end;
+            range(chunk, begin, end);
+            bytes.resize((end - begin) * stride);
+            uint8_t* rec = bytes.data();
+            for (size_t i = begin; i < end; ++i, rec += stride) {
+                for (int a = 0; a < 3; ++a) position(i, a, rec + a * position_size);
+                rgb(i, rec + xyz);
+                if (has_intensity) std::memcpy(rec + xyz + 3, &points.intensity[i], 4);
+                if (has_class) rec[base_stride - 1] = points.classification[i];
+                uint8_t* value = rec + base_stride;
+                for (const AttributeChannel& channel : attributes) {
+                    std::memcpy(value, &channel.bytes[i * channel.elementSize()], channel.elementSize());
+                    value += channel.elementSize();
+                }
+            }
+            return end - begin;
+        });
+    } else if (format == PointFileFormat::PcdBinary) {
+        ok = writeEncodedChunks(out, chunks, handle, [&](size_t chunk, std::vector<uint8_t>& bytes) {
+            size_t begin, end;
+            range(chunk, begin, end);
+            bytes.resize((end - begin) * record_size);
+            uint8_t* rec = bytes.data();
+            for (size_t i = begin; i < end; ++i)
+                for (size_t field : pcd_fields) {
+                    pcdValue(field, i, rec);
+                    rec += fieldSize(field);
+                }
+            return end - begin;
+        });
+    } else {
+        // Sizes go before the data: write placeholders and patch them at the end
+        const uint64_t raw_size = uint64_t(count) * record_size;
+        if (raw_size > UINT32_MAX) {
+            std::cerr << "Error: Too many points for binary_compressed PCD, use binary\n";
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+        std::streampos sizes_at = out.tellp();
+        uint32_t sizes[2] = { 0, static_cast<uint32_t>(raw_size) };
+        out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+
+        // Chunks run field by field, so the concatenated input is the field-major layout
+        ok = writeEncodedChunks(out, chunks * pcd_fields.size(), handle, [&](size_t task, std::vector<uint8_t>& bytes) {
+            size_t f = task / chunks, begin, end;
+            range(task % chunks, begin, end);
+            const size_t size = fieldSize(pcd_fields[f]);
+            std::vector<uint8_t> raw((end - begin) * size);
+            for (size_t i = begin; i < end; ++i)
+                pcdValue(pcd_fields[f], i, &raw[(i - begin) * size]);
+            bytes.resize(lzfBound(raw.size()));
+            bytes.resize(lzfCompress(raw.data(), raw.size(), bytes.data()));
+            return f + 1 == pcd_fields.size() ? end - begin : 0; // Points are done with their last field
+        });
+        sizes[0] = static_cast<uint32_t>(static_cast<uint64_t>(out.tellp()) - static_cast<uint64_t>(sizes_at) - sizeof(sizes));
+        out.seekp(sizes_at);
+        out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    }
+    out.close();
+    if (!ok || !out) {
+        std::remove(tmp.c_str());
+        if (!(handle && handle->isCancelled()))
+            std::cerr << "Error: Could not write " << filename << std::endl;
+        return false;
+    }
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Error: Could not rename " << tmp << " to " << filename << ": " << std::strerror(errno) << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ==========================
+// Binary Event Recording Format
+// ==========================
+//
+// A compact replacement for CSV event recordings (x,y,polarity,timestamp), written for
+// direct memory mapping (.cpev):
+//
+//   EventFileHeader                       at offset 0 (64 bytes)
+//   per block, at EventBlock::data_offset:
+//     uint32_t packed[count]              x | y << 15 | polarity << 30
+//     uint16_t delta[count]               Timestamp minus the previous event's (0 first)
+//   EventBlock[block_count]               at header.index_offset
+//
+// A block holds up to EVENT_BLOCK_EVENTS consecutive events; a time step that does not
+// fit in 16 bits (or goes backwards) starts a new block. The index stores each block's
+// first and last timestamp and is sorted by the last one, so seeking is a binary search
+// over the index that decodes no earlier data, even if the source went back in time.
+// Events take 6 bytes instead of ~15 bytes of text.
+
+struct EventFileHeader {
+    char magic[8];              // "CPEVENT\0"
+    uint32_t version;
+    uint32_t block_events;      // Maximum events per block
+    uint64_t event_count;
+    uint64_t block_count;
+    uint64_t index_offset;
+    int64_t time_first;         // Timestamps keep the unit of the source (milliseconds for CSV)
+    int64_t time_last;
+    uint8_t reserved[8];
+};
+static_assert(sizeof(EventFileHeader) == 64, "EventFileHeader layout");
+
+struct EventBlock {
+    uint64_t data_offset;
+    uint32_t count;
+    uint32_t reserved;
+    int64_t time_begin;
+    int64_t time_end;
+};
+static_assert(sizeof(EventBlock) == 32, "EventBlock layout");
+
+constexpr char EVENT_FILE_MAGIC[8] = { 'C', 'P', 'E', 'V', 'E', 'N', 'T', '\0' };
+constexpr uint32_t EVENT_FILE_VERSION = 1;
+constexpr uint32_t EVENT_COORD_MAX = (1u << 15) - 1;
+
+inline uint32_t packEvent(uint32_t x, uint32_t y, uint32_t polarity) {
+    return x | (y << 15) | ((polarity ? 1u : 0u) << 30);
+}
+
+inline size_t eventBlockBytes(size_t count) {
+    return (count * (sizeof(uint32_t) + sizeof(uint16_t)) + 7) & ~size_t{7};
+}
+
+// Parse a non-negative or negative decimal integer; returns false if none is found
+inline bool parseEventField(const char*& p, const char* end, int64_t& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    bool negative = p < end && *p == '-';
+    if (negative) ++p;
+    if (p >= end || *p < '0' || *p > '9') return false;
+    int64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    value = negative ? -v : v;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p == ',') ++p;
+    return true;
+}
+
+// Function to convert a CSV event recording (x,y,polarity,timestamp) to the binary event
+// format. Newline-aligned slices of the mapped CSV are parsed and block-encoded in parallel.
+inline bool convertEventsCSV(const std::string& csv_filename, const std::string& out_filename) {
+    MappedFile csv(csv_filename);
+    if (!csv.isOpen()) {
+        std::cerr << "Error: Could not open CSV file " << csv_filename << std::endl;
+        return false;
+    }
+    csv.adviseSequential();
+    const char* text = reinterpret_cast<const char*>(csv.data());
+    const char* text_end = text + csv.size();
+
+    // Skip the header line if present
+    const char* body = text;
+    if (body < text_end && !(*body >= '0' && *body <= '9') && *body != '-') {
+        body = static_cast<const char*>(std::memchr(body, '\n', text_end - body));
+        body = body ? body + 1 : text_end;
+    }
+
+    // Newline-aligned slices
+    std::vector<const char*> cuts = { body };
+    while (cuts.back() < text_end) {
+        const char* cut = cuts.back() + std::min<size_t>(Config::EVENT_CONVERT_CHUNK_BYTES, text_end - cuts.back());
+        if (cut < text_end) {
+            const char* nl = static_cast<const char*>(std::memchr(cut, '\n', text_end - cut));
+            cut = nl ? nl + 1 : text_end;
+        }
+        cuts.push_back(cut);
+    }
+
+    struct EncodedSlice {
+        std::vector<uint8_t> data;
+        std::vector<EventBlock> blocks;     // data_offset relative to data
+        uint64_t events = 0, malformed = 0;
+    };
+    std::vector<EncodedSlice> slices(cuts.size() - 1);
+    parallelForChunks(slices.size(), 1, [&](size_t begin, size_t) {
+        EncodedSlice& slice = slices[begin];
+        std::vector<uint32_t> packed;
+        std::vector<uint16_t> deltas;
+        EventBlock block{};
+        auto flush = [&]() {
+            if (packed.empty()) return;
+            block.data_offset = slice.data.size();
+            block.count = static_cast<uint32_t>(packed.size());
+            slice.data.resize(slice.data.size() + eventBlockBytes(packed.size()));
+            uint8_t* out = slice.data.data() + block.data_offset;
+            std::memcpy(out, packed.data(), packed.size() * sizeof(uint32_t));
+            std::memcpy(out + packed.size() * sizeof(uint32_t), deltas.data(), deltas.size() * sizeof(uint16_t));
+            slice.blocks.push_back(block);
+            packed.clear();
+            deltas.clear();
+        };
+
+        const char* p = cuts[begin];
+        const char* end = cuts[begin + 1];
+        while (p < end) {
+            const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!line_end) line_end = end;
+            int64_t x, y, polarity, t;
+            const char* q = p;
+            p = line_end + 1;
+            if (!parseEventField(q, line_end, x) || !parseEventField(q, line_end, y) ||
+                !parseEventField(q, line_end, polarity) || !parseEventField(q, line_end, t) ||
+                x < 0 || y < 0 || x > EVENT_COORD_MAX || y > EVENT_COORD_MAX) {
+                if (q < line_end && *q != '\r') ++slice.malformed;
+                continue;
+            }
+            if (!packed.empty() && (t < block.time_end || t - block.time_end > 0xFFFF ||
+                                    packed.size() == Config::EVENT_BLOCK_EVENTS))
+                flush();
+            if (packed.empty()) {
+                block.time_begin = t;
+                block.time_end = t;
+            }
+            packed.push_back(packEvent(static_cast<uint32_t>(x), static_cast<uint32_t>(y), polarity != 0));
+            deltas.push_back(static_cast<uint16_t>(t - block.time_end));
+            block.time_end = t;
+            ++slice.events;
+        }
+        flush();
+    });
+
+    // Lay the slices out one after the other, then the index
+    EventFileHeader header{};
+    std::memcpy(header.magic, EVENT_FILE_MAGIC, sizeof(header.magic));
+    header.version = EVENT_FILE_VERSION;
+    header.block_events = static_cast<uint32_t>(Config::EVENT_BLOCK_EVENTS);
+    std::vector<EventBlock> index;
+    uint64_t offset = sizeof(EventFileHeader), malformed = 0;
+    for (EncodedSlice& slice : slices) {
+        for (EventBlock block : slice.blocks) {
+            block.data_offset += offset;
+            index.push_back(block);
+        }
+        offset += slice.data.size();
+        header.event_count += slice.events;
+        malformed += slice.malformed;
+    }
+    // Blocks of a recording whose timestamps go backwards overlap; keep findBlock() valid
+    std::stable_sort(index.begin(), index.end(),
+        [](const EventBlock& a, const EventBlock& b) { return a.time_end < b.time_end; });
+    header.block_count = index.size();
+    header.index_offset = offset;
+    header.time_first = index.empty() ? 0 : index.front().time_begin;
+    for (const EventBlock& block : index) header.time_first = std::min(header.time_first, block.time_begin);
+    header.time_last = index.empty() ? 0 : index.back().time_end;
+
+    std::string tmp = temporaryPath(out_filename);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Could not create event file " << out_filename << std::endl;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const EncodedSlice& slice : slices)
+            out.write(reinterpret_cast<const char*>(slice.data.data()), slice.data.size());
+        out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(EventBlock));
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            std::cerr << "Error: Could not write event file " << out_filename << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), out_filename.c_str()) != 0) {
+        std::cerr << "Error: Could not rename " << tmp << " to " << out_filename << ": " << std::strerror(errno) << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    std::cout << "Converted " << header.event_count << " events (" << header.block_count << " blocks, "
+              << malformed << " malformed lines skipped) to " << out_filename << std::endl;
+    return true;
+}
+
+// Memory-mapped binary event recording
+class EventFile {
+public:
+    bool open(const std::string& filename) {
+        if (!file_.open(filename)) {
+            std::cerr << "Error: Could not open event file " << filename << std::endl;
+            return false;
+        }
+        if (file_.size() < sizeof(EventFileHeader)) return invalid(filename);
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (std::memcmp(header_.magic, EVENT_FILE_MAGIC, sizeof(header_.magic)) != 0 ||
+            header_.version != EVENT_FILE_VERSION ||
+            header_.index_offset + header_.block_count * sizeof(EventBlock) > file_.size())
+            return invalid(filename);
+        blocks_ = reinterpret_cast<const EventBlock*>(file_.data() + header_.index_offset);
+        for (size_t b = 0; b < header_.block_count; ++b) {
+            if (blocks_[b].data_offset + eventBlockBytes(blocks_[b].count) > header_.index_offset ||
+                (b > 0 && blocks_[b].time_end < blocks_[b - 1].time_end)) // findBlock() needs a sorted index
+                return invalid(filename);
+        }
+        return true;
+    }
+
+    const EventFileHeader& header() const { return header_; }
+    size_t blockCount() const { return header_.block_count; }
+    const EventBlock& block(size_t b) const { return blocks_[b]; }
+
+    // First block that ends at or after time t (blockCount() if none); every earlier block
+    // ends before t since the index is sorted by time_end
+    size_t findBlock(int64_t t) const {
+        const EventBlock* it = std::lower_bound(blocks_, blocks_ + header_.block_count, t,
+            [](const EventBlock& block, int64_t time) { return block.time_end < time; });
+        return static_cast<size_t>(it - blocks_);
+    }
+
+    // Decode block b, calling fn(x, y, polarity, t) for each event in order
+    template <typename Fn>
+    void forEachEvent(size_t b, Fn&& fn) const {
+        const EventBlock& block = blocks_[b];
+        const uint8_t* data = file_.data() + block.data_offset;
+        const uint8_t* deltas = data + block.count * sizeof(uint32_t);
+        int64_t t = block.time_begin;
+        for (uint32_t i = 0; i < block.count; ++i) {
+            uint32_t packed;
+            uint16_t delta;
+            std::memcpy(&packed, data + i * sizeof(uint32_t), sizeof(packed));
+            std::memcpy(&delta, deltas + i * sizeof(uint16_t), sizeof(delta));
+            t += delta;
+            fn(packed & EVENT_COORD_MAX, (packed >> 15) & EVENT_COORD_MAX, (packed >> 30) & 1u, t);
+        }
+    }
+
+private:
+    bool invalid(const std::string& filename) {
+        std::cerr << "Error: " << filename << " is not a valid event file" << std::endl;
+        file_.close();
+        return false;
+    }
+
+    MappedFile file_;
+    EventFileHeader header_{};
+    const EventBlock* blocks_ = nullptr;
+};
+
+
+// ==========================
+// Event Decimation
+// ==========================
+
+// Bursts of events are reduced to a per-frame budget before they reach the viewer, so the
+// upload and draw cost of a frame stays bounded and playback keeps up with real time.
+
+enum class EventDecimation {
+    LatestPerPixel, // Keep the newest event of each pixel, then sample down if still over budget
+    Random          // Uniform sample of the frame's events
+};
+
+struct EventDecimationOptions {
+    size_t frame_budget = Config::EVENT_FRAME_BUDGET; // 0 shows every event
+    EventDecimation mode = EventDecimation::LatestPerPixel;
+    bool balance_polarity = true; // Sample ON and OFF events in their input ratio
+};
+
+struct EventDecimationStats {
+    uint64_t frames = 0;
+    uint64_t decimated_frames = 0; // Frames that were over budget
+    uint64_t received = 0;
+    uint64_t shown = 0;
+    uint64_t dropped = 0;
+};
+
+struct EventRecord {
+    uint32_t x, y, polarity;
+    int64_t t;
+};
+
+// Reduces frames of events (in time order) to at most the budget, keeping their order
+class EventDecimator {
+public:
+    static constexpr uint32_t MAX_PIXEL_GRID = 4096; // Events beyond this are never merged
+
+    explicit EventDecimator(const EventDecimationOptions& options = {}) : options_(options) {}
+
+    void decimate(std::vector<EventRecord>& events) {
+        size_t received = events.size();
+        ++stats_.frames;
+        if (options_.frame_budget > 0 && received > options_.frame_budget) {
+            ++stats_.decimated_frames;
+            size_t counts[2] = { 0, 0 };
+            for (const EventRecord& e : events) ++counts[e.polarity ? 1 : 0];
+            if (options_.mode == EventDecimation::LatestPerPixel) keepLatestPerPixel(events);
+            if (events.size() > options_.frame_budget) sample(events, counts);
+        }
+        stats_.received += received;
+        stats_.shown += events.size();
+        stats_.dropped += received - events.size();
+    }
+
+    const EventDecimationStats& stats() const { return stats_; }
+
+private:
+    // Drop every event that a later event of the same frame overwrites
+    void keepLatestPerPixel(std::vector<EventRecord>& events) {
+        uint32_t width = width_, height = height_;
+        for (const EventRecord& e : events) {
+            if (e.x < MAX_PIXEL_GRID && e.y < MAX_PIXEL_GRID) {
+                width = std::max(width, e.x + 1);
+                height = std::max(height, e.y + 1);
+            }
+        }
+        if (width != width_ || height != height_ || ++generation_ == 0) {
+            width_ = width;
+            height_ = height;
+            generation_ = 1;
+            latest_.assign(static_cast<size_t>(width_) * height_, 0);
+        }
+        // Stamp each pixel with the generation and the index of its newest event
+        auto stamp = [&](size_t i) { return (static_cast<uint64_t>(generation_) << 32) | static_cast<uint32_t>(i); };
+        auto pixel = [&](const EventRecord& e) -> uint64_t* {
+            if (e.x >= MAX_PIXEL_GRID || e.y >= MAX_PIXEL_GRID) return nullptr; // Kept as is
+            return &latest_[static_cast<size_t>(e.y) * width_ + e.x];
+        };
+        for (size_t i = 0; i < events.size(); ++i)
+            if (uint64_t* p = pixel(events[i])) *p = stamp(i);
+        size_t kept = 0;
+        for (size_t i = 0; i < events.size(); ++i) {
+            const uint64_t* p = pixel(events[i]);
+            if (!p || *p == stamp(i)) events[kept++] = events[i];
+        }
+        events.resize(kept);
+    }
+
+    // Selection sampling of exactly frame_budget events in one ordered pass. With polarity
+    // balance each polarity gets a share of the budget matching its share of the input.
+    void sample(std::vector<EventRecord>& events, const size_t input_counts[2]) {
+        size_t budget = options_.frame_budget;
+        size_t available[2] = { 0, 0 };
+        for (const EventRecord& e : events) ++available[e.polarity ? 1 : 0];
+        size_t quota[2];
+        if (options_.balance_polarity) {
+            size_t input = input_counts[0] + input_counts[1];
+            quota[1] = std::min(available[1], static_cast<size_t>(static_cast<double>(budget) * input_counts[1] / input + 0.5));
+            quota[0] = std::min(available[0], budget - quota[1]);
+            quota[1] = std::min(available[1], budget - quota[0]); // Hand unused budget to the other polarity
+        }
+
+        size_t kept = 0, seen[2] = { 0, 0 }, chosen[2] = { 0, 0 }, seen_all = 0, chosen_all = 0;
+        for (const EventRecord& e : events) {
+            bool keep;
+            if (options_.balance_polarity) {
+                int p = e.polarity ? 1 : 0;
+                keep = random() * (available[p] - seen[p]++) < quota[p] - chosen[p];
+                if (keep) ++chosen[p];
+            } else {
+                keep = random() * (events.size() - seen_all++) < budget - chosen_all;
+                if (keep) ++chosen_all;
+            }
+            if (keep) events[kept++] = e;
+        }
+        events.resize(kept);
+    }
+
+    // Uniform double in [0, 1) from a splitmix64 sequence
+    double random() {
+        uint64_t z = (random_state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<double>((z ^ (z >> 31)) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    EventDecimationOptions options_;
+    EventDecimationStats stats_;
+    std::vector<uint64_t> latest_; // Per pixel: generation << 32 | index of the newest event
+    uint32_t width_ = 0, height_ = 0, generation_ = 0;
+    uint64_t random_state_ = 0;
+};
+
+// Simple 4x4 Matrix structure for transformations
+struct Matrix4x4 {
+    std::array<float, 16> data = {
+        1.0f, 0.0f, 0.0f, 0.0f, 
+        0.0f, 1.0f, 0.0f, 0.0f, 
+        0.0f, 0.0f, 1.0f, 0.0f, 
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    static Matrix4x4 identity() {
+    Matrix4x4 mat;
+        mat.data = {
+            1.0f, 0.0f, 0.0f, 0.0f, 
+            0.0f, 1.0f, 0.0f, 0.0f, 
+            0.0f, 0.0f, 1.0f, 0.0f, 
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+        return mat;
+    }
+    
+    // Matrix multiplication (Column-Major)
+    Matrix4x4 operator*(const Matrix4x4& other) const {
+        Matrix4x4 result;
+        for(int row=0; row<4; ++row)
+            for(int col=0; col<4; ++col) {
+                result.data[col*4 + row] = 0.0f;
+                for(int k=0; k<4; ++k)
+                    result.data[col*4 + row] += data[k*4 + row] * other.data[col*4 + k];
+            }
+        return result;
+    }
+};
+
+// Frustum planes (a*x + b*y + c*z + d >= 0 inside) extracted from a column-major MVP matrix
+struct Frustum {
+    std::array<std::array<float, 4>, 6> planes;
+
+    static Frustum fromMatrix(const Matrix4x4& m) {
+        auto row = [&](int r, int c) { return m.data[c * 4 + r]; };
+        Frustum f;
+        for (int i = 0; i < 3; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                f.planes[i * 2][c] = row(3, c) + row(i, c);
+                f.planes[i * 2 + 1][c] = row(3, c) - row(i, c);
+            }
+        }
+        return f;
+    }
+
+    bool intersectsBox(const float box_min[3], const float box_max[3]) const {
+        for (const auto& p : planes) {
+            // Test the box corner furthest along the plane normal
+            float x = p[0] >= 0.0f ? box_max[0] : box_min[0];
+            float y = p[1] >= 0.0f ? box_max[1] : box_min[1];
+            float z = p[2] >= 0.0f ? box_max[2] : box_min[2];
+            if (p[0] * x + p[1] * y + p[2] * z + p[3] < 0.0f) return false;
+        }
+        return true;
+    }
+};
+
+// ==========================
+// GPU Memory Budget
+// ==========================
+
+// Accounts for every GPU buffer the viewer owns and keeps evictable allocations (point chunks,
+// tiles) in an LRU resident set under a byte budget. Owners register allocations with an
+// eviction callback; reserve() evicts the least recently used entries not touched in the
+// current frame until the new allocation fits. Used from the render thread only.
+class GpuMemoryBudget {
+public:
+    using Handle = uint64_t;
+
+    struct Stats {
+        size_t budget_bytes = 0;
+        size_t used_bytes = 0;
+        size_t peak_bytes = 0;
+        size_t pinned_bytes = 0;        // Never evicted (grid, axes, ...)
+        size_t resident_entries = 0;    // Evictable allocations currently on the GPU
+        size_t evictions = 0;
+        size_t evicted_bytes = 0;
+        size_t uploads = 0;             // Evictable allocations made, including re-uploads
+        size_t out_of_memory = 0;       // GL_OUT_OF_MEMORY reported by the driver
+    };
+
+    explicit GpuMemoryBudget(size_t budget_bytes) : configured_bytes_(budget_bytes) { stats_.budget_bytes = budget_bytes; }
+
+    void setBudget(size_t bytes) { stats_.budget_bytes = configured_bytes_ = bytes; }
+
+    // Register memory that stays resident for the lifetime of its owner
+    Handle trackPinned(size_t bytes) {
+        Handle h = next_handle_++;
+        pinned_[h] = bytes;
+        stats_.pinned_bytes += bytes;
+        add(bytes);
+        return h;
+    }
+
+    // Register an evictable allocation; evict releases the GPU memory when room is needed
+    Handle trackEvictable(size_t bytes, std::function<void()> evict, uint64_t frame) {
+        Handle h = next_handle_++;
+        lru_.push_back({ h, bytes, frame, std::move(evict) });
+        entries_[h] = std::prev(lru_.end());
+        ++stats_.uploads;
+        add(bytes);
+        recover(bytes);
+        return h;
+    }
+
+    // Mark an allocation as used in this frame (moves it to the back of the LRU order)
+    void touch(Handle h, uint64_t frame) {
+        auto it = entries_.find(h);
+        if (it == entries_.end()) return;
+        it->second->last_frame = frame;
+        lru_.splice(lru_.end(), lru_, it->second);
+    }
+
+    // The owner released the memory itself
+    void release(Handle h) {
+        if (auto it = entries_.find(h); it != entries_.end()) {
+            stats_.used_bytes -= it->second->bytes;
+            lru_.erase(it->second);
+            entries_.erase(it);
+        } else if (auto p = pinned_.find(h); p != pinned_.end()) {
+            stats_.used_bytes -= p->second;
+            stats_.pinned_bytes -= p->second;
+            pinned_.erase(p);
+        }
+    }
+
+    // Evict least recently used allocations not touched in this frame until bytes fit
+    bool reserve(size_t bytes, uint64_t frame) {
+        while (stats_.used_bytes + bytes > stats_.budget_bytes) {
+            if (lru_.empty() || lru_.front().last_frame >= frame) return false;
+            Entry victim = std::move(lru_.front());
+            lru_.pop_front();
+            entries_.erase(victim.handle);
+            stats_.used_bytes -= victim.bytes;
+            ++stats_.evictions;
+            stats_.evicted_bytes += victim.bytes;
+            victim.evict();
+        }
+        return true;
+    }
+
+    // The driver ran out of memory: lower the budget to what is actually in use. Successful
+    // uploads raise it again step by step, so a transient shortage (another process briefly
+    // holding VRAM) does not cap the resident set for the rest of the session.
+    void reportOutOfMemory() {
+        ++stats_.out_of_memory;
+        stats_.budget_bytes = std::min(stats_.budget_bytes, stats_.used_bytes);
+    }
+
+    Stats stats() const {
+        Stats s = stats_;
+        s.resident_entries = lru_.size();
+        return s;
+    }
+
+private:
+    struct Entry {
+        Handle handle;
+        size_t bytes;
+        uint64_t last_frame;
+        std::function<void()> evict;
+    };
+
+    void add(size_t bytes) {
+        stats_.used_bytes += bytes;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.used_bytes);
+    }
+
+    // Grow a lowered budget back towards the configured one by the size of each successful
+    // upload plus an eighth of the remaining gap
+    void recover(size_t bytes) {
+        if (stats_.budget_bytes >= configured_bytes_) return;
+        size_t gap = configured_bytes_ - stats_.budget_bytes;
+        stats_.budget_bytes += std::min(gap, bytes + gap / 8);
+    }
+
+    std::list<Entry> lru_;                                  // Front = least recently used
+    std::unordered_map<Handle, std::list<Entry>::iterator> entries_;
+    std::unordered_map<Handle, size_t> pinned_;
+    Handle next_handle_ = 1;
+    size_t configured_bytes_;                               // Budget requested by the user
+    Stats stats_;
+};
+
+// ==========================
+// Out-of-Core Tiled Point Format
+// ==========================
+//
+// A tile file (.cpt) is an octree written for direct memory mapping:
+//
+//   TileFileHeader                        at offset 0
+//   TileNode[node_count]                  at header.index_offset (breadth-first, root first)
+//   TileVertex[...] per node              at node.data_offset (contiguous per node)
+//
+// Every point is stored exactly once. Interior nodes hold an evenly thinned sample of
+// their subtree (the level of detail), leaves hold the rest, so drawing a node and all
+// of its selected ancestors gives the full density for that region.
+
+// GPU-ready interleaved vertex of a tile (position + normalized RGBA8 colour)
+struct TileVertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+static_assert(sizeof(TileVertex) == 16, "TileVertex must stay tightly packed");
+
+struct TileFileHeader {
+    char magic[8];              // "CPTILES\0"
+    uint32_t version;
+    uint32_t node_count;
+    uint64_t point_count;
+    uint64_t index_offset;
+    uint64_t data_offset;
+    float bounds_min[3];        // Cubic root bounds
+    float bounds_max[3];
+    uint8_t reserved[64];
+};
+static_assert(sizeof(TileFileHeader) == 128, "TileFileHeader layout is part of the file format");
+
+struct TileNode {
+    float bounds_min[3];
+    float bounds_max[3];
+    float spacing;              // Approximate distance between neighbouring points of this node
+    uint32_t point_count;
+    uint64_t data_offset;       // Byte offset of this node's TileVertex run
+    int32_t children[8];        // Node indices, -1 where the octant is empty
+    uint32_t depth;
+    uint32_t reserved;
+};
+static_assert(sizeof(TileNode) == 80, "TileNode layout is part of the file format");
+
+constexpr char TILE_FILE_MAGIC[8] = { 'C', 'P', 'T', 'I', 'L', 'E', 'S', '\0' };
+constexpr uint32_t TILE_FILE_VERSION = 1;
+
+struct TileBuildOptions {
+    uint32_t max_leaf_points = 65536;   // Leaves are split until they hold at most this many points
+    uint32_t lod_points = 16384;        // Target sample size kept in every interior node
+    uint32_t max_depth = 8;             // Depth of the counting grid (8 -> 256^3 cells)
+};
+
+// Uniform value in [0,1) derived from a point index and an octree depth
+inline double tileSampleHash(uint64_t index, uint32_t depth) {
+    uint64_t z = index * 0x9E3779B97F4A7C15ull + (static_cast<uint64_t>(depth) << 56) + 0x632BE59BD9B4E019ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Function to convert a binary PCD file into a tile file. Both files are memory mapped and all
+// passes stream over the input, so the converter does not need the cloud to fit in RAM.
+inline bool buildTilesFromPCD(const std::string& pcd_filename, const std::string& tile_filename,
+                              const TileBuildOptions& options = TileBuildOptions()) {
+    MappedFile input(pcd_filename);
+    PcdLayout layout;
+    if (!input.isOpen() || !parsePCDLayout(input, layout) || layout.point_count == 0) {
+        std::cerr << "Error: Could not open PCD for tiling: " << pcd_filename << '\n';
+        return false;
+    }
+    input.adviseSequential();
+    const uint8_t* records = input.data() + layout.data_offset;
+    const size_t count = layout.point_count;
+    const int axis_offsets[3] = { layout.x_offset, layout.y_offset, layout.z_offset };
+    const bool float_positions = layout.position_type == AttributeType::Float32;
+    auto position = [&](size_t i, float p[3]) {
+        const uint8_t* rec = records + i * layout.stride;
+        for (int a = 0; a < 3; ++a) {
+            if (float_positions) std::memcpy(&p[a], rec + axis_offsets[a], sizeof(float));
+            else p[a] = static_cast<float>(loadScalar<double>(rec + axis_offsets[a], false));
+        }
+    };
+
+    // Pass 1: bounds, reduced per chunk
+    size_t chunk_count = (count + Config::DECODE_CHUNK_POINTS - 1) / Config::DECODE_CHUNK_POINTS;
+    std::vector<std::array<float, 6>> chunk_bounds(chunk_count);
+    parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        std::array<float, 6> b = { INFINITY, INFINITY, INFINITY, -INFINITY, -INFINITY, -INFINITY };
+        for (size_t i = begin; i < end; ++i) {
+            float p[3];
+            position(i, p);
+            if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+            for (int a = 0; a < 3; ++a) {
+                b[a] = std::min(b[a], p[a]);
+                b[a + 3] = std::max(b[a + 3], p[a]);
+            }
+        }
+        chunk_bounds[begin / Config::DECODE_CHUNK_POINTS] = b;
+    });
+    float bmin[3] = { INFINITY, INFINITY, INFINITY }, bmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (const auto& b : chunk_bounds) {
+        for (int a = 0; a < 3; ++a) {
+            bmin[a] = std::min(bmin[a], b[a]);
+            bmax[a] = std::max(bmax[a], b[a + 3]);
+        }
+    }
+    if (bmin[0] > bmax[0]) {
+        std::cerr << "Error: PCD contains no finite points.\n";
+        return false;
+    }
+    float side = std::max({ bmax[0] - bmin[0], bmax[1] - bmin[1], bmax[2] - bmin[2], 1e-3f }) * 1.0001f;
+
+    // Depth of the counting grid: scans are mostly surfaces, so assume only about 4^depth of
+    // the 8^depth cells are occupied and go deep enough to split those into leaf-sized cells
+    uint32_t grid_depth = 1;
+    while (grid_depth < options.max_depth &&
+           (size_t{1} << (2 * grid_depth)) * options.max_leaf_points < count * 2)
+        ++grid_depth;
+    const uint32_t res = 1u << grid_depth;
+    auto cellOf = [&](const float p[3], uint32_t c[3]) {
+        for (int a = 0; a < 3; ++a)
+            c[a] = std::min(res - 1, static_cast<uint32_t>(std::max(0.0f, (p[a] - bmin[a]) / side * res)));
+    };
+
+    // Pass 2: per-cell counts, then a pyramid of counts for every coarser level (64-bit: the
+    // coarse cells of a multi-billion point cloud exceed 2^32)
+    std::vector<std::vector<uint64_t>> pyramid(grid_depth + 1);
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> cells(new std::atomic<uint64_t>[size_t(res) * res * res]);
+        for (size_t i = 0; i < size_t(res) * res * res; ++i) cells[i].store(0, std::memory_order_relaxed);
+        parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                float p[3];
+                position(i, p);
+                if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+                uint32_t c[3];
+                cellOf(p, c);
+                cells[(size_t(c[2]) * res + c[1]) * res + c[0]].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        pyramid[grid_depth].resize(size_t(res) * res * res);
+        for (size_t i = 0; i < pyramid[grid_depth].size(); ++i) pyramid[grid_depth][i] = cells[i].load();
+    }
+    for (int d = static_cast<int>(grid_depth) - 1; d >= 0; --d) {
+        uint32_t r = 1u << d;
+        pyramid[d].assign(size_t(r) * r * r, 0);
+        for (uint32_t z = 0; z < 2 * r; ++z)
+            for (uint32_t y = 0; y < 2 * r; ++y)
+                for (uint32_t x = 0; x < 2 * r; ++x)
+                    pyramid[d][(size_t(z / 2) * r + y / 2) * r + x / 2] +=
+                        pyramid[d + 1][(size_t(z) * 2 * r + y) * 2 * r + x];
+    }
+
+    // Build the hierarchy breadth-first. Interior nodes keep each arriving point with
+    // probability keep, chosen so that about lod_points of them stay at that level.
+    struct BuildNode { uint32_t depth, cx, cy, cz; double keep; TileNode node; };
+    std::vector<BuildNode> nodes;
+    nodes.push_back({ 0, 0, 0, 0, 0.0, {} });
+    std::vector<double> arriving = { static_cast<double>(pyramid[0][0]) };
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        const uint32_t depth = nodes[n].depth, cx = nodes[n].cx, cy = nodes[n].cy, cz = nodes[n].cz;
+        const uint32_t r = 1u << depth;
+        const uint64_t total = pyramid[depth][(size_t(cz) * r + cy) * r + cx];
+        TileNode& node = nodes[n].node;
+        std::fill(std::begin(node.children), std::end(node.children), -1);
+        node.depth = depth;
+        float node_side = side / static_cast<float>(r);
+        node.bounds_min[0] = bmin[0] + cx * node_side;
+        node.bounds_min[1] = bmin[1] + cy * node_side;
+        node.bounds_min[2] = bmin[2] + cz * node_side;
+        for (int a = 0; a < 3; ++a) node.bounds_max[a] = node.bounds_min[a] + node_side;
+
+        double keep = std::min(1.0, options.lod_points / std::max(arriving[n], 1.0));
+        bool leaf = total <= options.max_leaf_points || depth == grid_depth || keep >= 1.0;
+        nodes[n].keep = leaf ? 1.0 : keep;
+        if (leaf) continue;
+
+        // Children are appended after this node, which may reallocate nodes
+        double passing = arriving[n] * (1.0 - keep);
+        for (uint32_t o = 0; o < 8; ++o) {
+            uint32_t ccx = cx * 2 + (o & 1), ccy = cy * 2 + ((o >> 1) & 1), ccz = cz * 2 + ((o >> 2) & 1);
+            uint64_t child_total = pyramid[depth + 1][(size_t(ccz) * 2 * r + ccy) * 2 * r + ccx];
+            if (child_total == 0) continue;
+            nodes[n].node.children[o] = static_cast<int32_t>(nodes.size());
+            arriving.push_back(passing * static_cast<double>(child_total) / static_cast<double>(total));
+            nodes.push_back({ depth + 1, ccx, ccy, ccz, 0.0, {} });
+        }
+    }
+
+    // Node that stores point i: walk down until a node keeps it or a leaf is reached
+    auto nodeOf = [&](size_t i, const float p[3]) -> uint32_t {
+        uint32_t c[3];
+        cellOf(p, c);
+        uint32_t n = 0;
+        for (;;) {
+            const BuildNode& bn = nodes[n];
+            if (bn.keep >= 1.0 || tileSampleHash(i, bn.depth) < bn.keep) return n;
+            uint32_t shift = grid_depth - bn.depth - 1;
+            uint32_t o = ((c[0] >> shift) & 1) | (((c[1] >> shift) & 1) << 1) | (((c[2] >> shift) & 1) << 2);
+            n = static_cast<uint32_t>(bn.node.children[o]);
+        }
+    };
+
+    // Pass 3: points per node, then the file layout
+    std::unique_ptr<std::atomic<uint32_t>[]> node_counts(new std::atomic<uint32_t>[nodes.size()]);
+    for (size_t n = 0; n < nodes.size(); ++n) node_counts[n].store(0, std::memory_order_relaxed);
+    parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float p[3];
+            position(i, p);
+            if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+            node_counts[nodeOf(i, p)].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    TileFileHeader header = {};
+    std::memcpy(header.magic, TILE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TILE_FILE_VERSION;
+    header.node_count = static_cast<uint32_t>(nodes.size());
+    header.index_offset = sizeof(TileFileHeader);
+    header.data_offset = (header.index_offset + nodes.size() * sizeof(TileNode) + 4095) & ~uint64_t(4095);
+    for (int a = 0; a < 3; ++a) {
+        header.bounds_min[a] = bmin[a];
+        header.bounds_max[a] = bmin[a] + side;
+    }
+    uint64_t offset = header.data_offset;
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        TileNode& node = nodes[n].node;
+        node.point_count = node_counts[n].load();
+        node.data_offset = offset;
+        node.spacing = (node.bounds_max[0] - node.bounds_min[0]) / std::sqrt(std::max(1.0f, float(node.point_count)));
+        offset += uint64_t(node.point_count) * sizeof(TileVertex);
+        header.point_count += node.point_count;
+    }
+
+    int fd = ::open(tile_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+        std::cerr << "Error: Could not create tile file: " << tile_filename << '\n';
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: Could not map tile file for writing: " << tile_filename << '\n';
+        return false;
+    }
+    uint8_t* out = static_cast<uint8_t*>(mapped);
+    std::memcpy(out, &header, sizeof(header));
+    for (size_t n = 0; n < nodes.size(); ++n)
+        std::memcpy(out + header.index_offset + n * sizeof(TileNode), &nodes[n].node, sizeof(TileNode));
+
+    // Pass 4: scatter every point into its node's run
+    std::unique_ptr<std::atomic<uint32_t>[]> cursors(new std::atomic<uint32_t>[nodes.size()]);
+    for (size_t n = 0; n < nodes.size(); ++n) cursors[n].store(0, std::memory_order_relaxed);
+    parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            TileVertex v;
+            float p[3];
+            position(i, p);
+            if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+            v.x = p[0]; v.y = p[1]; v.z = p[2]; v.a = 255;
+            if (layout.rgb_offset >= 0) {
+                uint32_t rgb;
+                std::memcpy(&rgb, records + i * layout.stride + layout.rgb_offset, sizeof(rgb));
+                if ((rgb & 0xFFFFFF) == 0) rgb = 0xFFFFFF; // Black placeholder, as in decodePCDRecords()
+                v.r = (rgb >> 16) & 0xFF; v.g = (rgb >> 8) & 0xFF; v.b = rgb & 0xFF;
+            } else {
+                distanceToRGB(p[0], p[1], p[2], Config::COLOR_MAX_DISTANCE, v.r, v.g, v.b);
+            }
+            uint32_t n = nodeOf(i, p);
+            uint32_t slot = cursors[n].fetch_add(1, std::memory_order_relaxed);
+            std::memcpy(out + nodes[n].node.data_offset + uint64_t(slot) * sizeof(TileVertex), &v, sizeof(v));
+        }
+    });
+
+    msync(mapped, offset, MS_SYNC);
+    munmap(mapped, offset);
+    std::cout << "Wrote " << header.point_count << " points in " << nodes.size() << " tiles to " << tile_filename << '\n';
+    return true;
+}
+
+// Streams the visible, screen-relevant tiles of a tile file under RAM and VRAM budgets.
+// A loader thread copies requested tiles out of the mapping into a RAM cache; the render
+// thread selects tiles, uploads cached ones and draws whatever is resident on the GPU.
+class TiledPointCloud {
+public:
+    struct Stats {
+        size_t nodes_total = 0;
+        size_t nodes_selected = 0;
+        size_t nodes_drawn = 0;
+        size_t points_drawn = 0;
+        size_t ram_bytes = 0;
+        size_t gpu_bytes = 0;
+        size_t pending_loads = 0;
+    };
+
+    TiledPointCloud() = default;
+    TiledPointCloud(const TiledPointCloud&) = delete;
+    TiledPointCloud& operator=(const TiledPointCloud&) = delete;
+
+    ~TiledPointCloud() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (loader_.joinable()) loader_.join();
+    }
+
+    // Map a tile file and start the loader thread (no OpenGL calls). GPU memory for the
+    // tiles is taken from the given budget, shared with everything else the viewer draws.
+    bool open(const std::string& filename, GpuMemoryBudget* budget) {
+        budget_ = budget;
+        if (!file_.open(filename) || file_.size() < sizeof(TileFileHeader)) {
+            std::cerr << "Error: Could not map tile file: " << filename << '\n';
+            return false;
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (std::memcmp(header_.magic, TILE_FILE_MAGIC, sizeof(header_.magic)) != 0 ||
+            header_.version != TILE_FILE_VERSION ||
+            header_.index_offset + uint64_t(header_.node_count) * sizeof(TileNode) > file_.size()) {
+            std::cerr << "Error: Not a valid tile file: " << filename << '\n';
+            return false;
+        }
+        nodes_ = reinterpret_cast<const TileNode*>(file_.data() + header_.index_offset);
+        tiles_.resize(header_.node_count);
+        loader_ = std::thread(&TiledPointCloud::loadTiles, this);
+        std::cout << "Opened " << header_.point_count << " points in " << header_.node_count << " tiles from " << filename << '\n';
+        return true;
+    }
+
+    const TileFileHeader& header() const { return header_; }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats s = last_stats_;
+        s.ram_bytes = ram_bytes_;
+        s.pending_loads = wanted_.size();
+        return s;
+    }
+
+    // Start a frame: every viewport drawn until endFrame() shares one point budget, one
+    // upload budget and one list of load requests. Render thread only.
+    void beginFrame(uint64_t frame) {
+        frame_ = frame;
+        frame_points_ = 0;
+        frame_uploaded_ = 0;
+        frame_selected_.clear();
+        frame_wanted_.clear();
+        frame_stats_ = Stats();
+        frame_stats_.nodes_total = header_.node_count;
+    }
+
+    // Select, upload and draw tiles for one viewport. Tiles already selected by an earlier
+    // viewport of the frame are drawn without counting against the budget again. The caller
+    // binds the point shader and its MVP; must run on the thread that owns the OpenGL context.
+    void draw(const Matrix4x4& view_projection, const float eye[3], float fov_deg, int viewport_height) {
+        Frustum frustum = Frustum::fromMatrix(view_projection);
+        float pixels_per_unit = viewport_height / (2.0f * std::tan(fov_deg * 0.5f * static_cast<float>(M_PI) / 180.0f));
+
+        // Projected size in pixels of a length at the distance of a node's box
+        auto projected = [&](const TileNode& node, float length) {
+            float d2 = 0.0f;
+            for (int a = 0; a < 3; ++a) {
+                float d = std::max({ node.bounds_min[a] - eye[a], 0.0f, eye[a] - node.bounds_max[a] });
+                d2 += d * d;
+            }
+            return length * pixels_per_unit / std::max(std::sqrt(d2), 0.1f);
+        };
+
+        // Best-first traversal: coarse nodes first, refining where point spacing is visible
+        std::vector<uint32_t> selected;
+        std::priority_queue<std::pair<float, uint32_t>> queue;
+        queue.push({ std::numeric_limits<float>::max(), 0u });
+        while (!queue.empty()) {
+            uint32_t n = queue.top().second;
+            queue.pop();
+            const TileNode& node = nodes_[n];
+            if (!frustum.intersectsBox(node.bounds_min, node.bounds_max)) continue;
+            bool counted = tiles_[n].last_used == frame_; // Only the render thread writes last_used
+            if (!counted && frame_points_ + node.point_count > Config::TILE_POINT_BUDGET) continue;
+            selected.push_back(n);
+            if (!counted) frame_points_ += node.point_count;
+            if (projected(node, node.spacing) <= Config::TILE_REFINE_PIXELS) continue;
+            for (int32_t child : node.children) {
+                if (child < 0) continue;
+                const TileNode& c = nodes_[child];
+                queue.push({ projected(c, c.bounds_max[0] - c.bounds_min[0]), static_cast<uint32_t>(child) });
+            }
+        }
+
+        // Collect load requests for the frame and upload what the loader has cached
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (uint32_t n : selected) {
+                TileState& tile = tiles_[n];
+                if (tile.last_used != frame_) {
+                    tile.last_used = frame_;
+                    frame_selected_.push_back(n);
+                } else if (tile.vbo || tile.staged.empty()) {
+                    continue; // Handled by an earlier viewport
+                }
+                if (tile.vbo) {
+                    budget_->touch(tile.gpu, frame_);
+                    continue;
+                }
+                if (tile.staged.empty()) {
+                    if (!tile.loading) frame_wanted_.push_back(n);
+                    continue;
+                }
+                size_t bytes = tile.staged.size() * sizeof(TileVertex);
+                if (frame_uploaded_ >= Config::TILE_UPLOAD_BYTES_PER_FRAME || !budget_->reserve(bytes, frame_)) continue;
+                upload(tile);
+                frame_uploaded_ += bytes;
+            }
+        }
+
+        for (uint32_t n : selected) {
+            const TileState& tile = tiles_[n];
+            if (!tile.vao) continue;
+            glBindVertexArray(tile.vao);
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(nodes_[n].point_count));
+            ++frame_stats_.nodes_drawn;
+            frame_stats_.points_drawn += nodes_[n].point_count;
+        }
+        glBindVertexArray(0);
+    }
+
+    // Publish the frame's load requests to the loader, most important first, and its stats
+    void endFrame() {
+        frame_stats_.nodes_selected = frame_selected_.size();
+        for (uint32_t n : frame_selected_)
+            if (tiles_[n].vbo) frame_stats_.gpu_bytes += size_t(nodes_[n].point_count) * sizeof(TileVertex);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wanted_ = frame_wanted_;
+            last_stats_ = frame_stats_;
+        }
+        cv_.notify_one();
+    }
+
+    // Delete all GPU buffers; must run on the thread that owns the OpenGL context
+    void releaseGL() {
+        for (auto& tile : tiles_) {
+            if (!tile.vbo) continue;
+            budget_->release(tile.gpu);
+            release(tile);
+        }
+    }
+
+private:
+    struct TileState {
+        std::vector<TileVertex> staged;     // RAM cache of the tile, empty if not cached
+        bool loading = false;
+        GLuint vao = 0, vbo = 0;
+        GpuMemoryBudget::Handle gpu = 0;
+        uint64_t last_used = 0;             // Frame in which the tile was last selected
+    };
+
+    MappedFile file_;
+    TileFileHeader header_ = {};
+    const TileNode* nodes_ = nullptr;
+    std::vector<TileState> tiles_;
+    GpuMemoryBudget* budget_ = nullptr;     // Render thread only
+    std::atomic<uint64_t> frame_{0};
+
+    // Per-frame selection across viewports (render thread only)
+    size_t frame_points_ = 0;
+    size_t frame_uploaded_ = 0;
+    std::vector<uint32_t> frame_selected_;  // Union of the viewports' tiles
+    std::vector<uint32_t> frame_wanted_;
+    Stats frame_stats_;
+
+    mutable std::mutex mutex_;              // Guards staged/loading/last_used, wanted_, ram_bytes_
+    std::condition_variable cv_;
+    std::vector<uint32_t> wanted_;          // Tiles to load, most important first
+    size_t ram_bytes_ = 0;
+    bool stop_ = false;
+    Stats last_stats_;
+    std::thread loader_;
+
+    void upload(TileState& tile) {
+        glGenVertexArrays(1, &tile.vao);
+        glGenBuffers(1, &tile.vbo);
+        glBindVertexArray(tile.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, tile.vbo);
+        glBufferData(GL_ARRAY_BUFFER, tile.staged.size() * sizeof(TileVertex), tile.staged.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TileVertex), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        tile.gpu = budget_->trackEvictable(tile.staged.size() * sizeof(TileVertex), [&tile]() { release(tile); }, frame_);
+    }
+
+    static void release(TileState& tile) {
+        if (tile.vbo) glDeleteBuffers(1, &tile.vbo);
+        if (tile.vao) glDeleteVertexArrays(1, &tile.vao);
+        tile.vbo = tile.vao = 0;
+    }
+
+    // Loader thread: copy wanted tiles out of the mapping, keeping the RAM cache under budget
+    void loadTiles() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            if (wanted_.empty()) {
+                cv_.wait(lock);
+                continue;
+            }
+            uint32_t n = wanted_.front();
+            wanted_.erase(wanted_.begin());
+            TileState& tile = tiles_[n];
+            if (tile.loading || !tile.staged.empty()) continue;
+
+            size_t bytes = size_t(nodes_[n].point_count) * sizeof(TileVertex);
+            if (!reserveRam(bytes)) {
+                cv_.wait(lock);
+                continue;
+            }
+            tile.loading = true;
+            lock.unlock();
+
+            const uint8_t* src = file_.data() + nodes_[n].data_offset;
+            std::vector<TileVertex> data(nodes_[n].point_count);
+            std::memcpy(data.data(), src, bytes);
+            // The copy is cached; let the kernel drop the mapped pages again
+            uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+            uintptr_t first = reinterpret_cast<uintptr_t>(src) & ~(page - 1);
+            madvise(reinterpret_cast<void*>(first), reinterpret_cast<uintptr_t>(src) + bytes - first, MADV_DONTNEED);
+
+            lock.lock();
+            tile.staged = std::move(data);
+            tile.loading = false;
+        }
+    }
+
+    // Evict least recently selected cached tiles (not selected this frame) until bytes fit
+    bool reserveRam(size_t bytes) {
+        while (ram_bytes_ + bytes > Config::TILE_RAM_BUDGET_BYTES) {
+            TileState* victim = nullptr;
+            for (auto& t : tiles_) {
+                if (!t.staged.empty() && t.last_used < frame_ && (!victim || t.last_used < victim->last_used))
+                    victim = &t;
+            }
+            if (!victim) return false;
+            ram_bytes_ -= victim->staged.size() * sizeof(TileVertex);
+            victim->staged.clear();
+            victim->staged.shrink_to_fit();
+        }
+        ram_bytes_ += bytes;
+        return true;
+    }
+};
+
+// ==========================
+// Lock-Free Ingestion
+// ==========================
+
+// Bounded lock-free multi-producer/multi-consumer ring (Vyukov's sequence-per-cell design).
+// The viewer uses it with many producers and one consumer; capacity is rounded to a power of two.
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity) {
+        size_t size = 1;
+        while (size < std::max<size_t>(capacity, 2)) size <<= 1;
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    bool tryPush(T&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate number of queued items
+    size_t sizeApprox() const {
+        size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+// Low-latency wakeup for lock-free queues: signalling costs one atomic load unless a
+// thread is actually asleep, and the mutex/condition variable is only used to sleep.
+//   waiter:   key = prepareWait(); if (condition) cancelWait(); else wait(key);
+//   signaller: make condition true; notify();
+class EventCount {
+public:
+    uint64_t prepareWait() {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    void cancelWait() {
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wait(uint64_t key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_var_.wait(lock, [&]() { return epoch_.load(std::memory_order_acquire) != key; });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            epoch_.fetch_add(1, std::memory_order_release);
+        }
+        cond_var_.notify_all();
+    }
+
+private:
+    std::atomic<uint32_t> waiters_{0};
+    std::atomic<uint64_t> epoch_{0};
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+};
+
+// Lock-free latency histogram with power-of-two microsecond buckets
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKETS = 32;   // Bucket b counts latencies in [2^(b-1), 2^b) us
+
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> buckets{};
+        uint64_t count = 0;
+        double mean_us = 0.0;
+        double max_us = 0.0;
+
+        // Upper bound of the bucket containing the given quantile (0..1), in microseconds
+        double percentileUs(double q) const {
+            uint64_t target = static_cast<uint64_t>(std::ceil(q * count));
+            uint64_t seen = 0;
+            for (size_t b = 0; b < BUCKETS; ++b) {
+                seen += buckets[b];
+                if (seen >= target && seen > 0) return static_cast<double>(uint64_t{1} << b);
+            }
+            return max_us;
+        }
+    };
+
+    void record(std::chrono::nanoseconds latency) {
+        uint64_t us = static_cast<uint64_t>(std::max<int64_t>(latency.count() / 1000, 0));
+        size_t bucket = 0;
+        while (bucket + 1 < BUCKETS && (uint64_t{1} << bucket) <= us) ++bucket;
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        total_ns_.fetch_add(static_cast<uint64_t>(latency.count()), std::memory_order_relaxed);
+        uint64_t ns = static_cast<uint64_t>(latency.count());
+        uint64_t prev = max_ns_.load(std::memory_order_relaxed);
+        while (ns > prev && !max_ns_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (size_t b = 0; b < BUCKETS; ++b) s.buckets[b] = buckets_[b].load(std::memory_order_relaxed);
+        s.count = count_.load(std::memory_order_relaxed);
+        s.mean_us = s.count ? total_ns_.load(std::memory_order_relaxed) / 1000.0 / s.count : 0.0;
+        s.max_us = max_ns_.load(std::memory_order_relaxed) / 1000.0;
+        return s;
+    }
+
+    void reset() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        total_ns_.store(0, std::memory_order_relaxed);
+        max_ns_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+};
+
+// A batch of points handed from a producer to the processing thread
+struct IngestBatch {
+    PointBuffers points;
+    std::chrono::steady_clock::time_point enqueued;
+    bool failed = false;            // A pipeline stage threw; the batch is dropped
+};
+
+// What happens to the oldest points when a bounded viewer is full
+enum class EvictionPolicy {
+    Fifo,       // Drop the oldest points
+    Decimate    // Thin the oldest points 2:1, so old data fades out progressively
+};
+
+// What addPoints() does when the ingestion ring is full
+enum class Backpressure {
+    Block,      // Wait for the processing thread to make room
+    DropOldest, // Discard the oldest queued batch
+    DropNewest  // Discard the batch being added
+};
+
+// Bounds on the points kept by the viewer (zero disables a bound)
+struct CapacityOptions {
+    size_t max_points = 0;
+    EvictionPolicy eviction = EvictionPolicy::Fifo;
+    std::chrono::milliseconds max_age{0};   // Points older than this are expired
+};
+
+// Counters for points that did not make it to, or left, the displayed cloud
+struct IngestStats {
+    uint64_t batches_dropped = 0;   // By backpressure in addPoints(), rejected after stop, or failed in a stage
+    uint64_t points_dropped = 0;
+    uint64_t points_evicted = 0;    // FIFO eviction at capacity
+    uint64_t points_decimated = 0;  // Removed by thinning old data
+    uint64_t points_expired = 0;    // Older than max_age
+    size_t points_stored = 0;
+};
+
+// ==========================
+// Multi-Sensor Merge
+// ==========================
+
+using SourceId = uint32_t;
+
+// Per-source counters of the merge (see PointCloudViewer::sourceStats())
+struct SourceStats {
+    std::string name;
+    uint64_t batches = 0;            // Pushed by the source
+    uint64_t points = 0;
+    uint64_t published = 0;          // Handed to the viewer in time order
+    uint64_t late_dropped = 0;       // Older than a batch already published
+    uint64_t overflow_dropped = 0;   // Source queue full
+    std::chrono::nanoseconds lag{0}; // Newest timestamp of any source minus this source's newest
+    LatencyHistogram::Snapshot merge_wait; // Arrival to publication
+};
+
+// Timestamp-ordered k-way merge of batches from several sources (sensors). Timestamps must
+// share one clock and increase per source. The oldest head batch is published as soon as no
+// other source can still send an older one: it has sent something at least as new, or its
+// recent arrival delays (arrival minus timestamp) say its next batch must be newer. Otherwise
+// the batch is published when it has waited for the reorder window. A batch older than one
+// already published is dropped as late. The added latency is therefore bounded by the
+// window, one frame by default, and is usually the delay of the slowest source.
+class SourceMerger {
+public:
+    SourceId addSource(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sources_.push_back(std::make_unique<Source>());
+        sources_.back()->name = name;
+        return static_cast<SourceId>(sources_.size() - 1);
+    }
+
+    void setReorderWindow(std::chrono::nanoseconds window) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_ = window;
+        ready_.notify_all();
+    }
+
+    // Queue a batch of a source; false if it was dropped as late or for an unknown source
+    bool push(SourceId id, std::chrono::nanoseconds timestamp, PointBuffers&& points) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (id >= sources_.size()) {
+            std::cerr << "Error: Unknown point source " << id << std::endl;
+            return false;
+        }
+        Source& source = *sources_[id];
+        ++source.batches;
+        source.points += points.size();
+        auto arrived = std::chrono::steady_clock::now();
+        newest_ = std::max(newest_, timestamp);
+        source.newest = std::max(source.newest, timestamp);
+        auto delay = sinceEpoch(arrived) - timestamp;
+        if (!source.seen) source.delays.fill(delay);
+        source.delays[source.batches % source.delays.size()] = delay;
+        source.seen = true;
+        if (published_any_ && timestamp < published_) {
+            ++source.late_dropped;
+            return false;
+        }
+        if (source.queue.size() >= Config::MERGE_SOURCE_QUEUE) {
+            source.queue.pop_front();
+            ++source.overflow_dropped;
+        }
+        source.queue.push_back({ timestamp, arrived, std::move(points) });
+        ready_.notify_all();
+        return true;
+    }
+
+    // Wait until batches are due and move them to out in time order; false once closed
+    bool waitReady(std::vector<PointBuffers>& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            auto deadline = collect(out, std::chrono::steady_clock::now());
+            if (!out.empty()) return true;
+            if (closed_) return false;
+            if (deadline == std::chrono::steady_clock::time_point::max())
+                ready_.wait(lock);
+            else
+                ready_.wait_until(lock, deadline);
+        }
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        ready_.notify_all();
+    }
+
+    std::vector<SourceStats> stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<SourceStats> stats;
+        for (const auto& source : sources_) {
+            SourceStats s;
+            s.name = source->name;
+            s.batches = source->batches;
+            s.points = source->points;
+            s.published = source->published;
+            s.late_dropped = source->late_dropped;
+            s.overflow_dropped = source->overflow_dropped;
+            s.lag = source->seen ? newest_ - source->newest : std::chrono::nanoseconds(0);
+            s.merge_wait = source->wait.snapshot();
+            stats.push_back(std::move(s));
+        }
+        return stats;
+    }
+
+private:
+    struct Pending {
+        std::chrono::nanoseconds timestamp;
+        std::chrono::steady_clock::time_point arrived;
+        PointBuffers points;
+    };
+
+    struct Source {
+        std::string name;
+        std::deque<Pending> queue;
+        std::chrono::nanoseconds newest{0};
+        std::array<std::chrono::nanoseconds, 16> delays{}; // Arrival minus timestamp, recent batches
+        bool seen = false;
+        uint64_t batches = 0, points = 0, published = 0, late_dropped = 0, overflow_dropped = 0;
+        LatencyHistogram wait;
+    };
+
+    // Publish head batches in time order while that is safe or their wait ran out. Returns
+    // when the oldest remaining head becomes due (max() if nothing is queued). mutex_ held.
+    std::chrono::steady_clock::time_point collect(std::vector<PointBuffers>& out, std::chrono::steady_clock::time_point now) {
+        while (true) {
+            Source* oldest = nullptr;
+            for (const auto& source : sources_) {
+                if (!source->queue.empty() &&
+                    (!oldest || source->queue.front().timestamp < oldest->queue.front().timestamp))
+                    oldest = source.get();
+            }
+            if (!oldest) return std::chrono::steady_clock::time_point::max();
+
+            // Time from which no other source can send an older batch (now if already so)
+            Pending& head = oldest->queue.front();
+            auto safe = now;
+            for (const auto& source : sources_) {
+                if (source.get() == oldest || !source->queue.empty() || source->newest >= head.timestamp) continue;
+                if (!source->seen) {
+                    safe = std::chrono::steady_clock::time_point::max();
+                    break;
+                }
+                auto delay = *std::max_element(source->delays.begin(), source->delays.end());
+                auto from = std::chrono::steady_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(head.timestamp + delay));
+                safe = std::max(safe, from);
+            }
+            auto due = head.arrived + std::chrono::duration_cast<std::chrono::steady_clock::duration>(window_);
+            if (safe > now && due > now) return std::min(safe, due);
+
+            if (published_any_ && head.timestamp < published_) {
+                ++oldest->late_dropped; // Out of order within its own source
+            } else {
+                published_ = head.timestamp;
+                published_any_ = true;
+                ++oldest->published;
+                oldest->wait.record(now - head.arrived);
+                out.push_back(std::move(head.points));
+            }
+            oldest->queue.pop_front();
+        }
+    }
+
+    static std::chrono::nanoseconds sinceEpoch(std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch());
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    std::chrono::nanoseconds window_ = std::chrono::milliseconds(Config::MERGE_REORDER_WINDOW_MS);
+    std::chrono::nanoseconds newest_{0};
+    std::chrono::nanoseconds published_{0};
+    bool published_any_ = false;
+    bool closed_ = false;
+};
+
+// ==========================
+// Bird's-Eye-View Density Raster
+// ==========================
+
+// Cell value shown by the raster mode
+enum class RasterChannel {
+    Density,    // Points per cell (log scale)
+    MaxZ,       // Highest point of the cell
+    Intensity   // Mean intensity of the cell
+};
+
+struct RasterOptions {
+    float cell_size = Config::BEV_CELL_SIZE;    // Metres per cell (coarser if the extent needs it)
+    RasterChannel channel = RasterChannel::Density;
+};
+
+// Per-cell point count, maximum z and mean intensity of a cloud on an x/y grid. Batches are
+// binned in parallel as they arrive and removed points are subtracted again, so keeping the
+// raster current costs as much as the batch, not the cloud. The grid is rebuilt from all
+// points when points fall outside it (it is refitted with a margin) or when as many points
+// were removed as are stored, which also refreshes the max-z of cells that lost points.
+class DensityRaster {
+public:
+    bool empty() const { return width_ == 0; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    float cellSize() const { return cell_size_; }
+    const float* origin() const { return origin_; }
+
+    // Value ranges of the channels, for the colormap
+    uint32_t maxCount() const { return max_count_; }
+    float zMin() const { return z_range_[0]; }
+    float zMax() const { return z_range_[1]; }
+    float intensityMin() const { return intensity_range_[0]; }
+    float intensityMax() const { return intensity_range_[1]; }
+
+    bool needsRebuild() const { return rebuild_; }
+    void invalidate() { rebuild_ = true; }
+    size_t removedSinceRebuild() const { return removed_; }
+
+    // Release the grid (raster mode off)
+    void clear() {
+        count_ = std::vector<uint32_t>();
+        max_z_ = std::vector<float>();
+        intensity_sum_ = std::vector<float>();
+        width_ = height_ = 0;
+        rebuild_ = true;
+        dirty_ = false;
+    }
+
+    // Fit the grid to the points of the slot ranges and bin all of them
+    void rebuild(const float* positions, const float* intensity,
+                 const std::vector<std::pair<size_t, size_t>>& ranges, float cell_size) {
+        float bounds[4] = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+        std::mutex bounds_mutex;
+        for (const auto& range : ranges) {
+            parallelForChunks(range.second - range.first, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+                float local[4] = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+                for (size_t i = range.first + begin; i < range.first + end; ++i) {
+                    const float* p = positions + i * 3;
+                    if (!std::isfinite(p[0]) || !std::isfinite(p[1])) continue;
+                    local[0] = std::min(local[0], p[0]);
+                    local[1] = std::min(local[1], p[1]);
+                    local[2] = std::max(local[2], p[0]);
+                    local[3] = std::max(local[3], p[1]);
+                }
+                std::lock_guard<std::mutex> lock(bounds_mutex);
+                for (int a = 0; a < 2; ++a) {
+                    bounds[a] = std::min(bounds[a], local[a]);
+                    bounds[a + 2] = std::max(bounds[a + 2], local[a + 2]);
+                }
+            });
+        }
+        rebuild_ = false;
+        removed_ = 0;
+        if (bounds[0] > bounds[2]) {
+            clear();
+            rebuild_ = false;
+            return;
+        }
+
+        // A quarter of the extent as margin, so a growing live cloud rarely leaves the grid
+        float margin[2] = { 0.25f * (bounds[2] - bounds[0]), 0.25f * (bounds[3] - bounds[1]) };
+        float extent[2] = { bounds[2] - bounds[0] + 2.0f * margin[0], bounds[3] - bounds[1] + 2.0f * margin[1] };
+        cell_size_ = std::max({ cell_size, extent[0] / Config::BEV_MAX_CELLS, extent[1] / Config::BEV_MAX_CELLS, 1e-6f });
+        origin_[0] = bounds[0] - margin[0];
+        origin_[1] = bounds[1] - margin[1];
+        width_ = std::min(Config::BEV_MAX_CELLS, static_cast<int>(extent[0] / cell_size_) + 1);
+        height_ = std::min(Config::BEV_MAX_CELLS, static_cast<int>(extent[1] / cell_size_) + 1);
+
+        size_t cells = static_cast<size_t>(width_) * height_;
+        count_.assign(cells, 0);
+        max_z_.assign(cells, -INFINITY);
+        intensity_sum_.assign(cells, 0.0f);
+        max_count_ = 0;
+        z_range_[0] = intensity_range_[0] = INFINITY;
+        z_range_[1] = intensity_range_[1] = -INFINITY;
+        for (const auto& range : ranges)
+            accumulate(positions, intensity, range.first, range.second, 1);
+        markDirty(0, 0, width_, height_);
+    }
+
+    // Bin (sign = 1) or subtract (sign = -1) the points [first, last). Returns false, leaving
+    // the grid untouched, if an added point lies outside it.
+    bool accumulate(const float* positions, const float* intensity, size_t first, size_t last, int sign) {
+        size_t count = last - first;
+        if (count == 0 || width_ == 0) return width_ != 0 || sign < 0;
+
+        // Cell of every point; non-finite points are ignored
+        constexpr uint32_t SKIP = std::numeric_limits<uint32_t>::max();
+        cells_.resize(count);
+        std::atomic<bool> outside{false};
+        const float inv_cell = 1.0f / cell_size_;
+        parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const float* p = positions + (first + i) * 3;
+                float fx = (p[0] - origin_[0]) * inv_cell;
+                float fy = (p[1] - origin_[1]) * inv_cell;
+                cells_[i] = SKIP;
+                if (!std::isfinite(fx) || !std::isfinite(fy) || !std::isfinite(p[2])) continue;
+                if (fx < 0.0f || fy < 0.0f || fx >= width_ || fy >= height_) {
+                    outside.store(true, std::memory_order_relaxed);
+                    continue;
+                }
+                cells_[i] = static_cast<uint32_t>(fy) * width_ + static_cast<uint32_t>(fx);
+            }
+        });
+        if (outside && sign > 0) return false;
+
+        // Sort the points into bands of rows (counting sort per chunk), then bin each band
+        // in parallel: bands own disjoint cells, so no atomics are needed
+        const size_t chunk = Config::DECODE_CHUNK_POINTS;
+        const size_t chunks = (count + chunk - 1) / chunk;
+        const size_t bands = count < Config::BEV_PARALLEL_POINTS ? 1 : std::min<size_t>(height_, 64);
+        const size_t rows_per_band = (height_ + bands - 1) / bands;
+        const size_t band_cells = rows_per_band * width_;
+        std::vector<size_t> offsets(bands * chunks + 1, 0);
+        parallelForChunks(count, chunk, [&](size_t begin, size_t end) {
+            size_t c = begin / chunk;
+            for (size_t i = begin; i < end; ++i)
+                if (cells_[i] != SKIP) ++offsets[(cells_[i] / band_cells) * chunks + c + 1];
+        });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        order_.resize(offsets.back());
+        parallelForChunks(count, chunk, [&](size_t begin, size_t end) {
+            size_t c = begin / chunk;
+            std::vector<size_t> next(bands);
+            for (size_t b = 0; b < bands; ++b) next[b] = offsets[b * chunks + c];
+            for (size_t i = begin; i < end; ++i)
+                if (cells_[i] != SKIP) order_[next[cells_[i] / band_cells]++] = static_cast<uint32_t>(i);
+        });
+
+        std::mutex stats_mutex;
+        parallelForChunks(bands, 1, [&](size_t band, size_t) {
+            uint32_t max_count = 0;
+            float z_range[2] = { INFINITY, -INFINITY };
+            float intensity_range[2] = { INFINITY, -INFINITY };
+            int rect[4] = { width_, height_, 0, 0 };
+            for (size_t k = offsets[band * chunks]; k < offsets[(band + 1) * chunks]; ++k) {
+                size_t i = order_[k];
+                uint32_t cell = cells_[i];
+                float z = positions[(first + i) * 3 + 2];
+                if (sign > 0) {
+                    max_count = std::max(max_count, ++count_[cell]);
+                    max_z_[cell] = std::max(max_z_[cell], z);
+                    z_range[0] = std::min(z_range[0], z);
+                    z_range[1] = std::max(z_range[1], z);
+                    if (intensity) intensity_sum_[cell] += intensity[first + i];
+                } else if (count_[cell] > 0) {
+                    if (--count_[cell] == 0) {
+                        max_z_[cell] = -INFINITY;
+                        intensity_sum_[cell] = 0.0f;
+                    } else if (intensity) {
+                        intensity_sum_[cell] -= intensity[first + i];
+                    }
+                }
+                if (intensity && sign > 0) {
+                    intensity_range[0] = std::min(intensity_range[0], intensity[first + i]);
+                    intensity_range[1] = std::max(intensity_range[1], intensity[first + i]);
+                }
+                int x = static_cast<int>(cell % width_), y = static_cast<int>(cell / width_);
+                rect[0] = std::min(rect[0], x);
+                rect[1] = std::min(rect[1], y);
+                rect[2] = std::max(rect[2], x + 1);
+                rect[3] = std::max(rect[3], y + 1);
+            }
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            max_count_ = std::max(max_count_, max_count);
+            z_range_[0] = std::min(z_range_[0], z_range[0]);
+            z_range_[1] = std::max(z_range_[1], z_range[1]);
+            intensity_range_[0] = std::min(intensity_range_[0], intensity_range[0]);
+            intensity_range_[1] = std::max(intensity_range_[1], intensity_range[1]);
+            if (rect[0] < rect[2]) markDirty(rect[0], rect[1], rect[2], rect[3]);
+        });
+        if (sign < 0) removed_ += count;
+        return true;
+    }
+
+    // Take the cells changed since the last call as [x0, x1) x [y0, y1)
+    bool takeDirty(int rect[4]) {
+        if (!dirty_) return false;
+        std::copy_n(dirty_rect_, 4, rect);
+        dirty_ = false;
+        return true;
+    }
+
+    // (count, max z, mean intensity) of the cells in rect, row by row
+    void texels(const int rect[4], std::vector<float>& out) const {
+        size_t w = rect[2] - rect[0], h = rect[3] - rect[1];
+        out.resize(w * h * 3);
+        parallelForChunks(h, 16, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                size_t cell = (rect[1] + y) * width_ + rect[0];
+                float* dst = out.data() + y * w * 3;
+                for (size_t x = 0; x < w; ++x, ++cell) {
+                    uint32_t n = count_[cell];
+                    dst[x * 3 + 0] = static_cast<float>(n);
+                    dst[x * 3 + 1] = n ? max_z_[cell] : 0.0f;
+                    dst[x * 3 + 2] = n ? intensity_sum_[cell] / n : 0.0f;
+                }
+            }
+        });
+    }
+
+private:
+    void markDirty(int x0, int y0, int x1, int y1) {
+        if (!dirty_) {
+            dirty_rect_[0] = x0; dirty_rect_[1] = y0;
+            dirty_rect_[2] = x1; dirty_rect_[3] = y1;
+            dirty_ = true;
+            return;
+        }
+        dirty_rect_[0] = std::min(dirty_rect_[0], x0);
+        dirty_rect_[1] = std::min(dirty_rect_[1], y0);
+        dirty_rect_[2] = std::max(dirty_rect_[2], x1);
+        dirty_rect_[3] = std::max(dirty_rect_[3], y1);
+    }
+
+    int width_ = 0, height_ = 0;
+    float cell_size_ = Config::BEV_CELL_SIZE;
+    float origin_[2] = { 0.0f, 0.0f };          // x/y of the grid corner
+    std::vector<uint32_t> count_;
+    std::vector<float> max_z_;
+    std::vector<float> intensity_sum_;
+    uint32_t max_count_ = 0;
+    float z_range_[2] = { INFINITY, -INFINITY };
+    float intensity_range_[2] = { INFINITY, -INFINITY };
+    bool rebuild_ = true;
+    size_t removed_ = 0;                        // Points subtracted since the last rebuild
+    bool dirty_ = false;
+    int dirty_rect_[4] = { 0, 0, 0, 0 };
+    std::vector<uint32_t> cells_, order_;      // Scratch space of accumulate()
+};
+
+// ==========================
+// Batch Processing Pipeline
+// ==========================
+
+// A processing step applied to every batch from addPoints() (crop, downsample, colour, ...).
+// Stages edit the batch in place and may drop points. Different batches pass the stages
+// concurrently, so a stage must not modify state shared between calls. A batch whose stage
+// throws is dropped, since the stage may have left its channels at different lengths.
+using PointStage = std::function<void(PointBuffers&)>;
+
+// Counters of one pipeline stage
+struct StageStats {
+    std::string name;
+    uint64_t batches = 0;
+    uint64_t points_in = 0;
+    uint64_t points_out = 0;
+    LatencyHistogram::Snapshot latency;     // Time spent in the stage per batch
+
+    // Points processed per second of stage time
+    double pointsPerSecond() const {
+        double seconds = latency.mean_us * latency.count * 1e-6;
+        return seconds > 0.0 ? points_in / seconds : 0.0;
+    }
+};
+
+// The ordered list of stages with per-stage counters. The list can change while batches are
+// in flight: each batch runs on the snapshot it started with.
+class BatchPipeline {
+public:
+    struct Stage {
+        std::string name;
+        PointStage run;
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> points_in{0};
+        std::atomic<uint64_t> points_out{0};
+        LatencyHistogram latency;
+    };
+    using StageList = std::vector<std::shared_ptr<Stage>>;
+
+    void addStage(const std::string& name, PointStage stage) {
+        auto entry = std::make_shared<Stage>();
+        entry->name = name;
+        entry->run = std::move(stage);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto stages = std::make_shared<StageList>(*stages_);
+        stages->push_back(std::move(entry));
+        stages_ = std::move(stages);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stages_ = std::make_shared<StageList>();
+    }
+
+    std::shared_ptr<const StageList> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stages_;
+    }
+
+    // Run a batch through the stages of a snapshot. A stage that throws is reported and the
+    // remaining stages are skipped; false tells the caller to drop the half-modified batch.
+    static bool run(const StageList& stages, PointBuffers& points) {
+        for (const auto& stage : stages) {
+            auto start = std::chrono::steady_clock::now();
+            size_t count = points.size();
+            bool ok = false;
+            try {
+                stage->run(points);
+                ok = true;
+            } catch (const std::exception& e) {
+                std::cerr << "[Error] Pipeline stage " << stage->name << " failed: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "[Error] Pipeline stage " << stage->name << " failed" << std::endl;
+            }
+            stage->latency.record(std::chrono::steady_clock::now() - start);
+            stage->batches.fetch_add(1, std::memory_order_relaxed);
+            stage->points_in.fetch_add(count, std::memory_order_relaxed);
+            if (!ok) return false;
+            stage->points_out.fetch_add(points.size(), std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    std::vector<StageStats> stats() const {
+        std::vector<StageStats> result;
+        for (const auto& stage : *snapshot()) {
+            StageStats s;
+            s.name = stage->name;
+            s.batches = stage->batches.load(std::memory_order_relaxed);
+            s.points_in = stage->points_in.load(std::memory_order_relaxed);
+            s.points_out = stage->points_out.load(std::memory_order_relaxed);
+            s.latency = stage->latency.snapshot();
+            result.push_back(std::move(s));
+        }
+        return result;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const StageList> stages_ = std::make_shared<StageList>();
+};
+
+// Keep the points for which keep(i) is true, compacting every channel in place
+template <typename Keep>
+inline void keepPoints(PointBuffers& points, Keep&& keep) {
+    size_t count = points.size(), kept = 0;
+    bool colors = !points.colors.empty();
+    bool intensity = !points.intensity.empty();
+    bool classification = !points.classification.empty();
+    bool cluster = !points.cluster.empty();
+    for (size_t i = 0; i < count; ++i) {
+        if (!keep(i)) continue;
+        if (kept != i) {
+            std::copy_n(&points.positions[i * 3], 3, &points.positions[kept * 3]);
+            if (colors) std::copy_n(&points.colors[i * 3], 3, &points.colors[kept * 3]);
+            if (intensity) points.intensity[kept] = points.intensity[i];
+            if (classification) points.classification[kept] = points.classification[i];
+            if (cluster) points.cluster[kept] = points.cluster[i];
+            for (AttributeChannel& channel : points.attributes) channel.copyFrom(channel, i, kept, 1);
+        }
+        ++kept;
+    }
+    points.positions.resize(kept * 3);
+    if (colors) points.colors.resize(kept * 3);
+    if (intensity) points.intensity.resize(kept);
+    if (classification) points.classification.resize(kept);
+    if (cluster) points.cluster.resize(kept);
+    for (AttributeChannel& channel : points.attributes) channel.bytes.resize(kept * channel.elementSize());
+}
+
+// Integer voxel coordinates packed into one hash key (21 bits per axis)
+inline uint64_t packVoxel(int64_t x, int64_t y, int64_t z) {
+    auto axis = [](int64_t v) { return static_cast<uint64_t>(v + (1 << 20)) & 0x1FFFFF; };
+    return axis(x) | (axis(y) << 21) | (axis(z) << 42);
+}
+
+inline uint64_t voxelKey(const float* p, float inv_leaf) {
+    return packVoxel(static_cast<int64_t>(std::floor(p[0] * inv_leaf)),
+                     static_cast<int64_t>(std::floor(p[1] * inv_leaf)),
+                     static_cast<int64_t>(std::floor(p[2] * inv_leaf)));
+}
+
+// Keep the points inside an axis-aligned box
+inline PointStage cropStage(const float box_min[3], const float box_max[3]) {
+    std::array<float, 6> box = { box_min[0], box_min[1], box_min[2], box_max[0], box_max[1], box_max[2] };
+    return [box](PointBuffers& points) {
+        const float* p = points.positions.data();
+        keepPoints(points, [&](size_t i) {
+            return p[i * 3] >= box[0] && p[i * 3 + 1] >= box[1] && p[i * 3 + 2] >= box[2] &&
+                   p[i * 3] <= box[3] && p[i * 3 + 1] <= box[4] && p[i * 3 + 2] <= box[5];
+        });
+    };
+}
+
+// Replace the points of each voxel of the given edge length by their centroid
+inline PointStage voxelDownsampleStage(float leaf_size) {
+    return [leaf_size](PointBuffers& points) {
+        const float inv_leaf = 1.0f / leaf_size;
+        size_t count = points.size();
+        bool colors = !points.colors.empty();
+        bool intensity = !points.intensity.empty();
+        std::unordered_map<uint64_t, uint32_t> voxels;
+        voxels.reserve(count);
+        std::vector<uint32_t> voxel_of(count), members;
+        for (size_t i = 0; i < count; ++i) {
+            auto it = voxels.emplace(voxelKey(&points.positions[i * 3], inv_leaf), static_cast<uint32_t>(members.size())).first;
+            if (it->second == members.size()) members.push_back(0);
+            voxel_of[i] = it->second;
+            ++members[it->second];
+        }
+
+        // Accumulate into the slot of the first point of each voxel, then compact
+        std::vector<uint32_t> first(members.size(), UINT32_MAX);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t v = voxel_of[i];
+            if (first[v] == UINT32_MAX) {
+                first[v] = static_cast<uint32_t>(i);
+                continue;
+            }
+            size_t f = first[v];
+            for (int a = 0; a < 3; ++a) {
+                points.positions[f * 3 + a] += points.positions[i * 3 + a];
+                if (colors) points.colors[f * 3 + a] += points.colors[i * 3 + a];
+            }
+            if (intensity) points.intensity[f] += points.intensity[i];
+        }
+        for (size_t v = 0; v < members.size(); ++v) {
+            size_t f = first[v];
+            float inv = 1.0f / members[v];
+            for (int a = 0; a < 3; ++a) {
+                points.positions[f * 3 + a] *= inv;
+                if (colors) points.colors[f * 3 + a] *= inv;
+            }
+            if (intensity) points.intensity[f] *= inv;
+        }
+        keepPoints(points, [&](size_t i) { return first[voxel_of[i]] == i; });
+    };
+}
+
+// Colour the points by their distance from the origin (as the viewer does for uncoloured points)
+inline PointStage colormapStage(float max_distance = Config::COLOR_MAX_DISTANCE) {
+    return [max_distance](PointBuffers& points) {
+        size_t count = points.size();
+        points.colors.resize(count * 3);
+        for (size_t i = 0; i < count; ++i) {
+            const float* p = &points.positions[i * 3];
+            uint8_t r, g, b;
+            distanceToRGB(p[0], p[1], p[2], max_distance, r, g, b);
+            points.colors[i * 3 + 0] = r / 255.0f;
+            points.colors[i * 3 + 1] = g / 255.0f;
+            points.colors[i * 3 + 2] = b / 255.0f;
+        }
+    };
+}
+
+// Transform the points by a (column-major) rigid or affine matrix, e.g. sensor to world
+inline PointStage transformStage(const Matrix4x4& transform) {
+    return [m = transform.data](PointBuffers& points) {
+        size_t count = points.size();
+        for (size_t i = 0; i < count; ++i) {
+            float* p = &points.positions[i * 3];
+            float x = p[0], y = p[1], z = p[2];
+            p[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+            p[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+            p[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+        }
+    };
+}
+
+// Drop points with fewer than min_neighbors other points of the batch within radius
+inline PointStage outlierFilterStage(float radius, int min_neighbors) {
+    return [radius, min_neighbors](PointBuffers& points) {
+        const float inv_cell = 1.0f / radius;
+        const float radius_sq = radius * radius;
+        size_t count = points.size();
+        const float* p = points.positions.data();
+
+        // Points sorted by cell; neighbours are searched in the 27 cells around a point
+        std::vector<std::pair<uint64_t, uint32_t>> sorted(count);
+        for (size_t i = 0; i < count; ++i)
+            sorted[i] = { voxelKey(p + i * 3, inv_cell), static_cast<uint32_t>(i) };
+        std::sort(sorted.begin(), sorted.end());
+        std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> cells;
+        for (size_t k = 0; k < count; ) {
+            size_t end = k;
+            while (end < count && sorted[end].first == sorted[k].first) ++end;
+            cells[sorted[k].first] = { static_cast<uint32_t>(k), static_cast<uint32_t>(end) };
+            k = end;
+        }
+
+        std::vector<uint8_t> keep(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            const float* q = p + i * 3;
+            int64_t cell[3];
+            for (int a = 0; a < 3; ++a) cell[a] = static_cast<int64_t>(std::floor(q[a] * inv_cell));
+            int neighbors = 0;
+            for (int dz = -1; dz <= 1 && neighbors < min_neighbors; ++dz)
+            for (int dy = -1; dy <= 1 && neighbors < min_neighbors; ++dy)
+            for (int dx = -1; dx <= 1 && neighbors < min_neighbors; ++dx) {
+                auto it = cells.find(packVoxel(cell[0] + dx, cell[1] + dy, cell[2] + dz));
+                if (it == cells.end()) continue;
+                for (uint32_t k = it->second.first; k < it->second.second && neighbors < min_neighbors; ++k) {
+                    uint32_t j = sorted[k].second;
+                    if (j == i) continue;
+                    float ex = p[j * 3] - q[0], ey = p[j * 3 + 1] - q[1], ez = p[j * 3 + 2] - q[2];
+                    if (ex * ex + ey * ey + ez * ez <= radius_sq) ++neighbors;
+                }
+            }
+            keep[i] = neighbors >= min_neighbors;
+        }
+        keepPoints(points, [&](size_t i) { return keep[i] != 0; });
+    };
+}
+
+// Ground segmentation: what happens to the points on the fitted ground plane
+enum class GroundAction { Label, Strip };
+
+struct GroundOptions {
+    float distance_threshold = Config::GROUND_DISTANCE_THRESHOLD; // Max distance of ground points from the plane
+    float max_slope_deg = Config::GROUND_MAX_SLOPE_DEG;          // Steeper planes are not ground
+    int iterations = Config::GROUND_RANSAC_ITERATIONS;           // Plane hypotheses per sector
+    size_t sample_points = Config::GROUND_SAMPLE_POINTS;         // Points scoring each hypothesis
+    int sectors = 1;        // Azimuth sectors around the sensor fitted separately (uneven terrain)
+    GroundAction action = GroundAction::Label; // Label: classification = GROUND_CLASS, Strip: drop
+};
+
+// Random index for RANSAC hypotheses (hash of the draw, so hypotheses are independent tasks)
+inline uint32_t ransacIndex(uint64_t draw, uint32_t size) {
+    uint64_t z = draw + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<uint32_t>((z ^ (z >> 31)) % size);
+}
+
+// Fit the ground plane (n.p + d = 0, n.z > 0) of the given points by RANSAC over an evenly
+// strided sample, scoring the hypotheses in parallel, then refine it by least squares on the
+// inliers. Returns false if no plane within max_slope_deg was found.
+inline bool fitGroundPlane(const float* positions, const std::vector<uint32_t>& indices, const GroundOptions& options, float plane[4]) {
+    size_t stride = std::max<size_t>(1, indices.size() / std::max<size_t>(options.sample_points, 3));
+    std::vector<uint32_t> sample;
+    for (size_t k = 0; k < indices.size(); k += stride) sample.push_back(indices[k]);
+    if (sample.size() < 3) return false;
+
+    const float min_normal_z = std::cos(options.max_slope_deg * static_cast<float>(M_PI) / 180.0f);
+    const uint32_t size = static_cast<uint32_t>(sample.size());
+    auto inliers = [&](const std::array<float, 4>& h) {
+        uint32_t count = 0;
+        for (uint32_t i : sample) {
+            const float* p = positions + i * 3;
+            count += std::abs(h[0] * p[0] + h[1] * p[1] + h[2] * p[2] + h[3]) <= options.distance_threshold;
+        }
+        return count;
+    };
+
+    std::vector<std::array<float, 4>> hypotheses(std::max(options.iterations, 1));
+    std::vector<uint32_t> scores(hypotheses.size(), 0);
+    std::vector<size_t> order(hypotheses.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::for_each(std::execution::par, order.begin(), order.end(), [&](size_t h) {
+        const float* a = positions + sample[ransacIndex(h * 3 + 0, size)] * 3;
+        const float* b = positions + sample[ransacIndex(h * 3 + 1, size)] * 3;
+        const float* c = positions + sample[ransacIndex(h * 3 + 2, size)] * 3;
+        float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length < 1e-6f) return; // Collinear draw
+        if (n[2] < 0.0f) length = -length;
+        auto& hyp = hypotheses[h];
+        hyp = { n[0] / length, n[1] / length, n[2] / length, 0.0f };
+        if (hyp[2] < min_normal_z) return;
+        hyp[3] = -(hyp[0] * a[0] + hyp[1] * a[1] + hyp[2] * a[2]);
+        scores[h] = inliers(hyp);
+    });
+    size_t best = std::max_element(scores.begin(), scores.end()) - scores.begin();
+    if (scores[best] < 3) return false;
+
+    // Least-squares refinement z = ax + by + c over the sample inliers
+    const auto& h = hypotheses[best];
+    double s[3][3] = {}, r[3] = {};
+    for (uint32_t i : sample) {
+        const float* p = positions + i * 3;
+        if (std::abs(h[0] * p[0] + h[1] * p[1] + h[2] * p[2] + h[3]) > options.distance_threshold) continue;
+        double x[3] = { p[0], p[1], 1.0 };
+        for (int j = 0; j < 3; ++j) {
+            for (int k = 0; k < 3; ++k) s[j][k] += x[j] * x[k];
+            r[j] += x[j] * p[2];
+        }
+    }
+    auto det3 = [](const double m[3][3]) {
+        return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    };
+    double det = det3(s);
+    std::copy(h.begin(), h.end(), plane);
+    if (std::abs(det) < 1e-9) return true; // Degenerate inlier set: keep the RANSAC plane
+    double coef[3];
+    for (int c = 0; c < 3; ++c) { // Cramer's rule
+        double m[3][3];
+        for (int j = 0; j < 3; ++j)
+            for (int k = 0; k < 3; ++k) m[j][k] = k == c ? r[j] : s[j][k];
+        coef[c] = det3(m) / det;
+    }
+    double length = std::sqrt(coef[0] * coef[0] + coef[1] * coef[1] + 1.0);
+    if (1.0 / length < min_normal_z) return true;
+    plane[0] = static_cast<float>(-coef[0] / length);
+    plane[1] = static_cast<float>(-coef[1] / length);
+    plane[2] = static_cast<float>(1.0 / length);
+    plane[3] = static_cast<float>(-coef[2] / length);
+    return true;
+}
+
+// Find the ground of each batch by RANSAC plane fitting (one plane per azimuth sector around
+// the sensor origin, falling back to the whole-batch plane) and label or strip its points
+inline PointStage groundSegmentationStage(const GroundOptions& options = GroundOptions()) {
+    return [options](PointBuffers& points) {
+        const size_t count = points.size();
+        const float* p = points.positions.data();
+        const int sectors = std::max(options.sectors, 1);
+        std::vector<std::vector<uint32_t>> members(sectors + 1); // [sectors] holds every point
+        members[sectors].resize(count);
+        std::iota(members[sectors].begin(), members[sectors].end(), uint32_t{0});
+        if (sectors > 1) {
+            for (size_t i = 0; i < count; ++i) {
+                float angle = std::atan2(p[i * 3 + 1], p[i * 3]) + static_cast<float>(M_PI);
+                int s = std::min(static_cast<int>(angle * sectors / (2.0f * static_cast<float>(M_PI))), sectors - 1);
+                members[s].push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        std::vector<std::array<float, 4>> planes(sectors + 1);
+        std::vector<uint8_t> fitted(sectors + 1, 0);
+        std::vector<int> ids(sectors > 1 ? sectors + 1 : 1);
+        std::iota(ids.begin(), ids.end(), 0);
+        if (sectors == 1) ids[0] = 1;
+        std::for_each(std::execution::par, ids.begin(), ids.end(), [&](int s) {
+            fitted[s] = fitGroundPlane(p, members[s], options, planes[s].data());
+        });
+
+        std::vector<uint8_t> ground(count, 0);
+        for (int s = 0; s < sectors; ++s) {
+            const std::vector<uint32_t>& indices = members[sectors > 1 ? s : sectors];
+            int source = fitted[s] && sectors > 1 ? s : sectors;
+            if (!fitted[source]) continue;
+            const auto& h = planes[source];
+            parallelForChunks(indices.size(), Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; ++k) {
+                    const float* q = p + indices[k] * 3;
+                    ground[indices[k]] = std::abs(h[0] * q[0] + h[1] * q[1] + h[2] * q[2] + h[3]) <= options.distance_threshold;
+                }
+            });
+        }
+
+        if (options.action == GroundAction::Strip) {
+            keepPoints(points, [&](size_t i) { return !ground[i]; });
+            return;
+        }
+        if (points.classification.empty()) points.classification.assign(count, Config::UNCLASSIFIED_CLASS);
+        for (size_t i = 0; i < count; ++i)
+            if (ground[i]) points.classification[i] = Config::GROUND_CLASS;
+    };
+}
+
+struct ClusterOptions {
+    float tolerance = Config::CLUSTER_TOLERANCE;       // Max gap between neighbouring points of a cluster
+    size_t min_points = Config::CLUSTER_MIN_POINTS;    // Smaller clusters are noise (id 0)
+    size_t max_points = 0;                             // Larger clusters are noise too (0 = no limit)
+    bool skip_ground = true;                           // Leave points labelled GROUND_CLASS unclustered
+    bool colorize = true;                              // Colour points by cluster, noise grey
+};
+
+// Axis-aligned bounds of one cluster
+struct ClusterBox {
+    float min[3], max[3];
+    uint32_t id = 0;
+    uint32_t count = 0;
+};
+
+// Distinct colour per cluster id (golden-ratio hue steps), grey for noise
+inline void clusterColor(uint32_t id, float rgb[3]) {
+    if (id == 0) {
+        rgb[0] = rgb[1] = rgb[2] = 0.4f;
+        return;
+    }
+    float hue = std::fmod(static_cast<float>(id) * 0.618034f, 1.0f) * 6.0f;
+    int sector = static_cast<int>(hue);
+    float f = hue - sector, v = 1.0f, s = 0.75f;
+    float p = v * (1.0f - s), q = v * (1.0f - s * f), t = v * (1.0f - s * (1.0f - f));
+    const float table[6][3] = { {v, t, p}, {q, v, p}, {p, v, t}, {p, q, v}, {t, p, v}, {v, p, q} };
+    std::copy_n(table[sector % 6], 3, rgb);
+}
+
+// Bounds of every cluster (ids 1..n) of a batch
+inline std::vector<ClusterBox> clusterBoxes(const float* positions, const uint32_t* cluster, size_t count) {
+    std::vector<ClusterBox> boxes;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t id = cluster[i];
+        if (id == 0) continue;
+        if (id > boxes.size()) boxes.resize(id);
+        ClusterBox& box = boxes[id - 1];
+        const float* p = positions + i * 3;
+        if (box.count++ == 0) {
+            box.id = id;
+            std::copy_n(p, 3, box.min);
+            std::copy_n(p, 3, box.max);
+            continue;
+        }
+        for (int a = 0; a < 3; ++a) {
+            box.min[a] = std::min(box.min[a], p[a]);
+            box.max[a] = std::max(box.max[a], p[a]);
+        }
+    }
+    return boxes;
+}
+
+// Euclidean clustering of each batch: points closer than tolerance are joined in a lock-free
+// union-find. Points are hashed into cells of edge tolerance / sqrt(3), so all points of a
+// cell belong together; the cells are processed in parallel, each joining the forward half
+// of its neighbour cells at the first pair of points within tolerance.
+// Writes cluster ids (1..n in order of their first point, 0 for noise) to points.cluster.
+inline PointStage euclideanClusterStage(const ClusterOptions& options = ClusterOptions()) {
+    return [options](PointBuffers& points) {
+        const size_t count = points.size();
+        const float* p = points.positions.data();
+        const float inv_cell = std::sqrt(3.0f) / options.tolerance;
+        const float tolerance_sq = options.tolerance * options.tolerance;
+        const bool skip_ground = options.skip_ground && !points.classification.empty();
+        auto clustered = [&](size_t i) { return !skip_ground || points.classification[i] != Config::GROUND_CLASS; };
+
+        // Points sorted by cell, and the range of each cell
+        std::vector<std::pair<uint64_t, uint32_t>> sorted;
+        sorted.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            if (clustered(i)) sorted.emplace_back(voxelKey(p + i * 3, inv_cell), static_cast<uint32_t>(i));
+        std::sort(std::execution::par, sorted.begin(), sorted.end());
+        std::vector<std::pair<uint32_t, uint32_t>> cells;
+        std::unordered_map<uint64_t, uint32_t> cell_of_key;
+        for (size_t k = 0; k < sorted.size(); ) {
+            size_t end = k;
+            while (end < sorted.size() && sorted[end].first == sorted[k].first) ++end;
+            cell_of_key.emplace(sorted[k].first, static_cast<uint32_t>(cells.size()));
+            cells.emplace_back(static_cast<uint32_t>(k), static_cast<uint32_t>(end));
+            k = end;
+        }
+
+        // Roots link towards the smaller index, so concurrent unions agree on the result.
+        // Every point starts under the first point of its cell.
+        std::vector<std::atomic<uint32_t>> parent(count);
+        for (const auto& [first, last] : cells)
+            for (uint32_t k = first; k < last; ++k)
+                parent[sorted[k].second].store(sorted[first].second, std::memory_order_relaxed);
+        auto find = [&](uint32_t x) {
+            uint32_t up = parent[x].load(std::memory_order_relaxed);
+            while (up != x) {
+                uint32_t next = parent[up].load(std::memory_order_relaxed);
+                parent[x].compare_exchange_weak(up, next, std::memory_order_relaxed); // Path halving
+                x = up;
+                up = next;
+            }
+            return x;
+        };
+        auto unite = [&](uint32_t a, uint32_t b) {
+            while (true) {
+                a = find(a);
+                b = find(b);
+                if (a == b) return;
+                if (a < b) std::swap(a, b);
+                uint32_t expected = a;
+                if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+            }
+        };
+
+        // Cells up to two steps away can hold points within tolerance; visit each pair once
+        static const std::vector<std::array<int, 3>> forward = [] {
+            std::vector<std::array<int, 3>> offsets;
+            for (int dz = -2; dz <= 2; ++dz)
+                for (int dy = -2; dy <= 2; ++dy)
+                    for (int dx = -2; dx <= 2; ++dx)
+                        if (dz > 0 || (dz == 0 && (dy > 0 || (dy == 0 && dx > 0))))
+                            offsets.push_back({{dx, dy, dz}});
+            return offsets;
+        }();
+        parallelForChunks(cells.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                auto [first, last] = cells[c];
+                const uint32_t head = sorted[first].second;
+                int64_t cell[3];
+                for (int a = 0; a < 3; ++a) cell[a] = static_cast<int64_t>(std::floor(p[head * 3 + a] * inv_cell));
+                for (const auto& d : forward) {
+                    auto it = cell_of_key.find(packVoxel(cell[0] + d[0], cell[1] + d[1], cell[2] + d[2]));
+                    if (it == cell_of_key.end()) continue;
+                    auto [nfirst, nlast] = cells[it->second];
+                    if (find(head) == find(sorted[nfirst].second)) continue;
+                    bool joined = false;
+                    for (uint32_t k = first; k < last && !joined; ++k) {
+                        const float* a = p + sorted[k].second * 3;
+                        for (uint32_t m = nfirst; m < nlast; ++m) {
+                            const float* b = p + sorted[m].second * 3;
+                            float dx = b[0] - a[0], dy = b[1] - a[1], dz = b[2] - a[2];
+                            if (dx * dx + dy * dy + dz * dz <= tolerance_sq) {
+                                unite(head, sorted[nfirst].second);
+                                joined = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        // Number the clusters of accepted size in order of their first point
+        std::vector<uint32_t> size(count, 0), id_of_root(count, 0);
+        for (size_t i = 0; i < count; ++i)
+            if (clustered(i)) ++size[find(static_cast<uint32_t>(i))];
+        uint32_t next_id = 1;
+        points.cluster.assign(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            if (!clustered(i)) continue;
+            uint32_t root = find(static_cast<uint32_t>(i));
+            if (size[root] < options.min_points || (options.max_points && size[root] > options.max_points)) continue;
+            if (id_of_root[root] == 0) id_of_root[root] = next_id++;
+            points.cluster[i] = id_of_root[root];
+        }
+
+        if (options.colorize) {
+            points.colors.resize(count * 3);
+            for (size_t i = 0; i < count; ++i) clusterColor(points.cluster[i], &points.colors[i * 3]);
+        }
+    };
+}
+
+// ==========================
+// Clip Region
+// ==========================
+
+// How an axis-aligned box relates to a clip region
+enum class ClipOverlap { Outside, Partial, Inside };
+
+// Points shown: inside an oriented box (if enabled) and on the kept side of every clip plane.
+// The point shader evaluates the same test from uniforms, so changing the region re-uploads
+// nothing; extractRegion() applies it on the CPU.
+struct ClipRegion {
+    bool box = false;
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float half_size[3] = { 0.5f * Config::CLIP_BOX_SIZE, 0.5f * Config::CLIP_BOX_SIZE, 0.5f * Config::CLIP_BOX_SIZE };
+    float axes[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }; // Box axes (orthonormal)
+    std::vector<std::array<float, 4>> planes; // Keep a*x + b*y + c*z + d >= 0, at most MAX_CLIP_PLANES
+
+    bool active() const { return box || !planes.empty(); }
+
+    // Turn the box about z (degrees from the x axis)
+    void setYaw(float degrees) {
+        float rad = degrees * static_cast<float>(M_PI) / 180.0f;
+        float c = std::cos(rad), s = std::sin(rad);
+        float rotated[3][3] = { { c, s, 0.0f }, { -s, c, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+        std::memcpy(axes, rotated, sizeof(axes));
+    }
+
+    bool contains(const float* p) const {
+        if (box) {
+            float d[3] = { p[0] - center[0], p[1] - center[1], p[2] - center[2] };
+            for (int a = 0; a < 3; ++a)
+                if (std::fabs(d[0] * axes[a][0] + d[1] * axes[a][1] + d[2] * axes[a][2]) > half_size[a]) return false;
+        }
+        for (const auto& plane : planes)
+            if (plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3] < 0.0f) return false;
+        return true;
+    }
+
+    // Outside if the axis-aligned box lies beyond one face or plane, Inside if it lies within all
+    ClipOverlap classify(const float bounds_min[3], const float bounds_max[3]) const {
+        float c[3], e[3];
+        for (int a = 0; a < 3; ++a) {
+            c[a] = 0.5f * (bounds_min[a] + bounds_max[a]);
+            e[a] = 0.5f * (bounds_max[a] - bounds_min[a]);
+        }
+        // Signed distance range of the box along a direction
+        auto range = [&](const float* n, float& low, float& high) {
+            float mid = n[0] * c[0] + n[1] * c[1] + n[2] * c[2];
+            float reach = std::fabs(n[0]) * e[0] + std::fabs(n[1]) * e[1] + std::fabs(n[2]) * e[2];
+            low = mid - reach;
+            high = mid + reach;
+        };
+        bool inside = true;
+        float low, high;
+        if (box) {
+            for (int a = 0; a < 3; ++a) {
+                range(axes[a], low, high);
+                float at = axes[a][0] * center[0] + axes[a][1] * center[1] + axes[a][2] * center[2];
+                if (low > at + half_size[a] || high < at - half_size[a]) return ClipOverlap::Outside;
+                if (low < at - half_size[a] || high > at + half_size[a]) inside = false;
+            }
+        }
+        for (const auto& plane : planes) {
+            range(plane.data(), low, high);
+            if (high + plane[3] < 0.0f) return ClipOverlap::Outside;
+            if (low + plane[3] < 0.0f) inside = false;
+        }
+        return inside ? ClipOverlap::Inside : ClipOverlap::Partial;
+    }
+};
+
+// ==========================
+// Change Detection
+// ==========================
+
+struct ChangeOptions {
+    float threshold = Config::CHANGE_THRESHOLD;        // Closer points count as unchanged (grey)
+    float max_distance = Config::CHANGE_MAX_DISTANCE;  // Search radius and end of the colour ramp
+    float cell_size = 0.0f;                            // Index cell edge (0 = from the reference density)
+    size_t chunk_points = Config::CHANGE_CHUNK_POINTS; // Points compared and handed over per chunk
+};
+
+struct ChangeStats {
+    size_t points = 0;
+    size_t changed = 0;             // Points at least threshold away from the reference
+    double index_seconds = 0.0;     // Building the spatial index of the reference
+    double compare_seconds = 0.0;   // Distance queries, colouring and handing over
+};
+
+// Uniform grid over a point set for nearest-neighbour distance queries. The points are
+// stored sorted by cell and the cells are found through an open-addressing hash table.
+class PointGrid {
+public:
+    // Index count points (fewer than 2^32) in cells of the given edge
+    void build(const float* positions, size_t count, float cell_size) {
+        cell_size_ = cell_size;
+        inv_cell_ = 1.0f / cell_size;
+
+        std::vector<std::pair<uint64_t, uint32_t>> sorted(count);
+        parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                sorted[i] = { voxelKey(positions + i * 3, inv_cell_), static_cast<uint32_t>(i) };
+        });
+        std::sort(std::execution::par, sorted.begin(), sorted.end());
+        points_.resize(count * 3);
+        parallelForChunks(count, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k)
+                std::copy_n(positions + size_t(sorted[k].second) * 3, 3, &points_[k * 3]);
+        });
+
+        std::vector<std::pair<uint64_t, uint32_t>> cells; // Key and first point of each cell
+        for (size_t k = 0; k < count; ++k)
+            if (k == 0 || sorted[k].first != sorted[k - 1].first) cells.emplace_back(sorted[k].first, static_cast<uint32_t>(k));
+        size_t capacity = 16;
+        while (capacity < cells.size() * 2) capacity *= 2;
+        table_.assign(capacity, Cell());
+        mask_ = capacity - 1;
+        for (size_t c = 0; c < cells.size(); ++c) {
+            size_t slot = hash(cells[c].first) & mask_;
+            while (table_[slot].key != EMPTY) slot = (slot + 1) & mask_;
+            table_[slot] = { cells[c].first, cells[c].second,
+                             c + 1 < cells.size() ? cells[c + 1].second : static_cast<uint32_t>(count) };
+        }
+        cell_count_ = cells.size();
+    }
+
+    // Distance from q to the nearest indexed point, or max_distance if none is closer. Cells
+    // are searched in shells around q until no unsearched cell can hold a closer point.
+    float nearestDistance(const float q[3], float max_distance) const {
+        if (table_.empty()) return max_distance;
+        float best = max_distance * max_distance;
+        int64_t center[3];
+        float inside[3]; // Position of q within its cell
+        for (int a = 0; a < 3; ++a) {
+            float scaled = q[a] * inv_cell_;
+            center[a] = static_cast<int64_t>(std::floor(scaled));
+            inside[a] = (scaled - static_cast<float>(center[a])) * cell_size_;
+        }
+        int shells = static_cast<int>(std::ceil(max_distance * inv_cell_));
+        for (int k = 0; k <= shells; ++k) {
+            for (int dz = -k; dz <= k; ++dz)
+            for (int dy = -k; dy <= k; ++dy) {
+                bool face = std::abs(dz) == k || std::abs(dy) == k;
+                for (int dx = -k; dx <= k; dx += face ? 1 : 2 * std::max(k, 1)) {
+                    // Skip cells farther away than the best match so far
+                    float gap[3] = { axisGap(dx, inside[0]), axisGap(dy, inside[1]), axisGap(dz, inside[2]) };
+                    if (gap[0] * gap[0] + gap[1] * gap[1] + gap[2] * gap[2] >= best) continue;
+                    const Cell* cell = findCell(packVoxel(center[0] + dx, center[1] + dy, center[2] + dz));
+                    if (!cell) continue;
+                    for (uint32_t i = cell->first; i < cell->last; ++i) {
+                        const float* p = &points_[size_t(i) * 3];
+                        float ex = p[0] - q[0], ey = p[1] - q[1], ez = p[2] - q[2];
+                        best = std::min(best, ex * ex + ey * ey + ez * ez);
+                    }
+                }
+            }
+            float reach = k * cell_size_; // Every point beyond shell k is at least this far
+            if (best <= reach * reach) break;
+        }
+        return std::sqrt(best);
+    }
+
+    float cellSize() const { return cell_size_; }
+    size_t cellCount() const { return cell_count_; }
+
+    // Cell edge putting about CHANGE_CELL_POINTS points in a point's cell. Occupancy is measured
+    // on the cells whose key hashes into 1/64 of the range (an unbiased sample of cells) and the
+    // edge rescaled as for a surface, where points per cell grow with its area.
+    static float estimateCellSize(const float* positions, size_t count) {
+        constexpr float far = std::numeric_limits<float>::max();
+        float lo[3] = { far, far, far }, hi[3] = { -far, -far, -far };
+        size_t stride = std::max<size_t>(1, count / 65536);
+        for (size_t i = 0; i < count; i += stride)
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = std::min(lo[a], positions[i * 3 + a]);
+                hi[a] = std::max(hi[a], positions[i * 3 + a]);
+            }
+        float volume = 1.0f;
+        for (int a = 0; a < 3; ++a) volume *= std::max(hi[a] - lo[a], 1e-3f);
+        float cell = std::cbrt(volume * Config::CHANGE_CELL_POINTS / std::max<size_t>(count, 1));
+        for (int iteration = 0; iteration < 4 && count > 0; ++iteration) {
+            std::unordered_map<uint64_t, uint32_t> sampled;
+            size_t sampled_points = 0;
+            float inv = 1.0f / cell;
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t key = voxelKey(positions + i * 3, inv);
+                if ((hash(key) & 63) != 0) continue;
+                ++sampled[key];
+                ++sampled_points;
+            }
+            if (sampled.empty()) break;
+            double weighted = 0.0; // Occupancy of a point's cell, averaged over the points
+            for (const auto& cell_points : sampled) weighted += double(cell_points.second) * cell_points.second;
+            float mean = static_cast<float>(weighted / sampled_points);
+            if (mean > Config::CHANGE_CELL_POINTS * 0.5f && mean < Config::CHANGE_CELL_POINTS * 2.0f) break;
+            cell *= std::clamp(std::sqrt(Config::CHANGE_CELL_POINTS / mean), 0.25f, 4.0f);
+        }
+        return cell;
+    }
+
+private:
+    struct Cell {
+        uint64_t key = EMPTY;
+        uint32_t first = 0, last = 0;
+    };
+    static constexpr uint64_t EMPTY = ~uint64_t(0);
+
+    static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        return key ^ (key >> 33);
+    }
+
+    const Cell* findCell(uint64_t key) const {
+        for (size_t slot = hash(key) & mask_; table_[slot].key != EMPTY; slot = (slot + 1) & mask_)
+            if (table_[slot].key == key) return &table_[slot];
+        return nullptr;
+    }
+
+    // Distance along one axis from q to the cell offset by d
+    float axisGap(int d, float inside) const {
+        if (d > 0) return (d - 1) * cell_size_ + (cell_size_ - inside);
+        if (d < 0) return (-d - 1) * cell_size_ + inside;
+        return 0.0f;
+    }
+
+    float cell_size_ = 1.0f, inv_cell_ = 1.0f;
+    std::vector<float> points_;
+    std::vector<Cell> table_;
+    size_t mask_ = 0;
+    size_t cell_count_ = 0;
+};
+
+// Grey below the threshold, then blue to red up to max_distance
+inline void changeColor(float distance, const ChangeOptions& options, float rgb[3]) {
+    if (distance < options.threshold) {
+        rgb[0] = rgb[1] = rgb[2] = 0.55f;
+        return;
+    }
+    float t = std::min((distance - options.threshold) / std::max(options.max_distance - options.threshold, 1e-6f), 1.0f);
+    uint8_t r, g, b;
+    HSVtoRGB((1.0f - t) * 0.66f, 1.0f, 1.0f, r, g, b);
+    rgb[0] = r / 255.0f;
+    rgb[1] = g / 255.0f;
+    rgb[2] = b / 255.0f;
+}
+
+// Compare a cloud against a reference: index the reference, then hand the compared points to
+// sink chunk by chunk as their nearest-neighbour distances are found (in parallel). The
+// distances are returned in the intensity channel, the colours follow changeColor().
+inline ChangeStats detectChanges(const PointBuffers& reference, const PointBuffers& compared,
+                                 const ChangeOptions& options, const PointSink& sink) {
+    ChangeStats stats;
+    auto start = std::chrono::steady_clock::now();
+    // Cells finer than max_distance / CHANGE_MAX_SHELLS would make misses search too many cells
+    float cell_size = options.cell_size;
+    if (cell_size <= 0.0f)
+        cell_size = std::max(PointGrid::estimateCellSize(reference.positions.data(), reference.size()),
+                             options.max_distance / Config::CHANGE_MAX_SHELLS);
+    PointGrid grid;
+    grid.build(reference.positions.data(), reference.size(), cell_size);
+    auto indexed = std::chrono::steady_clock::now();
+    stats.index_seconds = std::chrono::duration<double>(indexed - start).count();
+
+    // Express the compared points in the reference's local frame
+    float shift[3];
+    for (int a = 0; a < 3; ++a) shift[a] = static_cast<float>(compared.origin[a] - reference.origin[a]);
+
+    size_t count = compared.size();
+    for (size_t first = 0; first < count; first += options.chunk_points) {
+        size_t n = std::min(options.chunk_points, count - first);
+        PointBuffers chunk;
+        chunk.resize(n, true);
+        std::copy_n(compared.origin, 3, chunk.origin);
+        std::atomic<size_t> changed{0};
+        parallelForChunks(n, Config::DECODE_CHUNK_POINTS / 16, [&](size_t begin, size_t end) {
+            size_t local = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const float* p = &compared.positions[(first + i) * 3];
+                float q[3] = { p[0] + shift[0], p[1] + shift[1], p[2] + shift[2] };
+                float distance = grid.nearestDistance(q, options.max_distance);
+                std::copy_n(p, 3, &chunk.positions[i * 3]);
+                chunk.intensity[i] = distance;
+                changeColor(distance, options, &chunk.colors[i * 3]);
+                local += distance >= options.threshold;
+            }
+            changed.fetch_add(local, std::memory_order_relaxed);
+        });
+        stats.changed += changed;
+        stats.points += n;
+        sink(std::move(chunk));
+    }
+    stats.compare_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - indexed).count();
+    return stats;
+}
+
+// Forward declaration of PointCloudViewer for callbacks
+class PointCloudViewer;
+
+// ==========================
+// Frame Capture
+// ==========================
+
+// CRC-32 (PNG chunks) and Adler-32 (zlib stream) checksums
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline uint32_t adler32Update(uint32_t adler, const uint8_t* data, size_t size) {
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    while (size > 0) {
+        size_t n = std::min<size_t>(size, 5552); // Largest run without overflowing 32 bits
+        for (size_t i = 0; i < n; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += n;
+        size -= n;
+    }
+    return (b << 16) | a;
+}
+
+// Function to write an RGB PNG from top-down RGB rows. The zlib stream uses stored
+// (uncompressed) deflate blocks: no compression library is needed and encoding runs at
+// memory speed, at the cost of larger files.
+inline bool writePNG(const std::string& filename, const uint8_t* rgb, int width, int height) {
+    auto be32 = [](std::vector<uint8_t>& out, uint32_t v) {
+        for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<uint8_t>(v >> s));
+    };
+    auto chunk = [&](std::ofstream& out, const char* type, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> head;
+        be32(head, static_cast<uint32_t>(data.size()));
+        head.insert(head.end(), type, type + 4);
+        uint32_t crc = crc32Update(0, head.data() + 4, 4);
+        crc = crc32Update(crc, data.data(), data.size());
+        std::vector<uint8_t> tail;
+        be32(tail, crc);
+        out.write(reinterpret_cast<const char*>(head.data()), head.size());
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+        out.write(reinterpret_cast<const char*>(tail.data()), tail.size());
+    };
+
+    // Scanlines with filter type 0, wrapped in stored deflate blocks of up to 65535 bytes
+    size_t row_bytes = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw((row_bytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw[y * (row_bytes + 1)] = 0;
+        std::memcpy(&raw[y * (row_bytes + 1) + 1], rgb + y * row_bytes, row_bytes);
+    }
+    std::vector<uint8_t> idat = { 0x78, 0x01 };
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    for (size_t pos = 0; pos < raw.size() || pos == 0; ) {
+        size_t n = std::min<size_t>(raw.size() - pos, 65535);
+        bool last = pos + n == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(n));
+        idat.push_back(static_cast<uint8_t>(n >> 8));
+        idat.push_back(static_cast<uint8_t>(~n));
+        idat.push_back(static_cast<uint8_t>(~n >> 8));
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+        if (last) break;
+    }
+    be32(idat, adler32Update(1, raw.data(), raw.size()));
+
+    std::vector<uint8_t> ihdr;
+    be32(ihdr, static_cast<uint32_t>(width));
+    be32(ihdr, static_cast<uint32_t>(height));
+    ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 }); // 8-bit RGB, no interlace
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+    chunk(out, "IHDR", ihdr);
+    chunk(out, "IDAT", idat);
+    chunk(out, "IEND", {});
+    return static_cast<bool>(out);
+}
+
+enum class CaptureFormat {
+    PngSequence,    // output is a directory (frame_000000.png, ...) or a single .png file
+    Raw,            // output is one file of consecutive top-down RGBA frames
+    Pipe            // output is a shell command that reads raw RGBA frames from stdin
+};
+
+struct CaptureOptions {
+    CaptureFormat format = CaptureFormat::PngSequence;
+    std::string output;
+    size_t max_frames = 0;          // Stop after this many frames (0 = until stopped)
+    bool lossless = false;          // Wait for the encoder instead of dropping frames (headless)
+};
+
+// Captures rendered frames without stalling the render loop: glReadPixels goes into a ring
+// of pixel-buffer objects, each mapped a few frames later when its fence has signalled, and
+// the pixels are handed to a background encoder thread. GL calls stay on the render thread.
+// finish() only releases the GL objects; the encoder drains its queue and closes the output
+// on its own thread.
+class FrameRecorder {
+public:
+    struct Stats {
+        uint64_t captured = 0;      // Frames read back
+        uint64_t encoded = 0;       // Frames written by the encoder
+        uint64_t dropped = 0;       // Frames skipped because the encoder fell behind
+    };
+
+    ~FrameRecorder() {
+        finish();
+        wait();
+    }
+
+    bool isRecording() const { return recording_; }
+    bool isDone() const { return recording_ && options_.max_frames && requested_ >= options_.max_frames; }
+
+    Stats stats() const {
+        Stats s;
+        s.captured = captured_.load();
+        s.encoded = encoded_.load();
+        s.dropped = dropped_.load();
+        return s;
+    }
+
+    // Start recording frames of width x height (render thread)
+    bool start(const CaptureOptions& options, int width, int height) {
+        finish();
+        wait(); // The previous encoder still owns the output and the frame buffers
+        options_ = options;
+        width_ = width;
+        height_ = height;
+        requested_ = 0;
+        captured_ = encoded_ = dropped_ = 0;
+        if (!openOutput()) return false;
+
+        size_t bytes = static_cast<size_t>(width_) * height_ * 4;
+        glGenBuffers(Config::CAPTURE_PBO_COUNT, pbos_);
+        for (GLuint pbo : pbos_) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        for (size_t i = 0; i < Config::CAPTURE_QUEUE_FRAMES; ++i) {
+            auto frame = std::make_unique<std::vector<uint8_t>>(bytes);
+            free_frames_.tryPush(std::move(frame));
+        }
+
+        recording_ = true;
+        encoder_running_ = true;
+        encoder_ = std::thread(&FrameRecorder::encodeFrames, this);
+        return true;
+    }
+
+    // Queue a readback of the current read framebuffer and hand frames whose readback has
+    // completed to the encoder (render thread, after drawing and before swapping)
+    void capture() {
+        if (!recording_ || isDone()) return;
+        size_t slot = requested_ % Config::CAPTURE_PBO_COUNT;
+        if (requested_ >= Config::CAPTURE_PBO_COUNT)
+            collect(slot, true); // The oldest readback is a few frames old and normally done
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[slot]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        fences_[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++requested_;
+
+        // Pick up any other readbacks that have already completed
+        for (size_t i = 1; i < Config::CAPTURE_PBO_COUNT; ++i)
+            collect((slot + i) % Config::CAPTURE_PBO_COUNT, false);
+    }
+
+    // Read back the outstanding frames and release the buffers (render thread). The encoder
+    // writes the queued frames and closes the output in the background.
+    void finish() {
+        if (!recording_) return;
+        for (size_t i = 0; i < Config::CAPTURE_PBO_COUNT; ++i)
+            collect((requested_ + i) % Config::CAPTURE_PBO_COUNT, true); // Oldest first
+        glDeleteBuffers(Config::CAPTURE_PBO_COUNT, pbos_);
+        std::fill(std::begin(pbos_), std::end(pbos_), 0);
+        recording_ = false;
+
+        encoder_running_ = false;
+        frames_ready_.notify();
+    }
+
+    // Block until the encoder of a finished recording has written every frame
+    void wait() {
+        if (encoder_.joinable()) encoder_.join();
+    }
+
+private:
+    // Copy a completed readback out of its PBO; wait only if asked to. A readback that has
+    // not completed within a second of waiting is given up, so its slot can be reused.
+    void collect(size_t slot, bool wait) {
+        GLsync fence = fences_[slot];
+        if (!fence) return;
+        GLenum status = glClientWaitSync(fence, 0, wait ? GLuint64(1000000000) : 0);
+        if (status == GL_TIMEOUT_EXPIRED && !wait) return;
+        glDeleteSync(fence);
+        fences_[slot] = nullptr;
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::unique_ptr<std::vector<uint8_t>> frame;
+        while (!free_frames_.tryPop(frame)) {
+            if (!options_.lossless) {
+                dropped_.fetch_add(1, std::memory_order_relaxed); // Encoder behind: keep the frame rate
+                return;
+            }
+            uint64_t key = frames_free_.prepareWait();
+            if (free_frames_.tryPop(frame)) {
+                frames_free_.cancelWait();
+                break;
+            }
+            frames_free_.wait(key);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[slot]);
+        if (const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame->size(), GL_MAP_READ_BIT)) {
+            std::memcpy(frame->data(), pixels, frame->size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            ready_frames_.tryPush(std::move(frame)); // Both rings hold every frame buffer
+            captured_.fetch_add(1, std::memory_order_relaxed);
+            frames_ready_.notify();
+        } else {
+            free_frames_.tryPush(std::move(frame));
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    bool openOutput() {
+        if (options_.format == CaptureFormat::Raw) {
+            file_ = std::fopen(options_.output.c_str(), "wb");
+        } else if (options_.format == CaptureFormat::Pipe) {
+            file_ = popen(options_.output.c_str(), "w");
+        } else {
+            bool single = fileExtension(options_.output) == ".png";
+            std::error_code ec;
+            if (!single) std::filesystem::create_directories(options_.output, ec);
+            return true;
+        }
+        if (!file_) {
+            std::cerr << "Error: Could not open capture output " << options_.output << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void closeOutput() {
+        if (!file_) return;
+        if (options_.format == CaptureFormat::Pipe) pclose(file_);
+        else std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    // Encoder thread: flip the bottom-up readback to top-down rows and write it out; after
+    // finish() it drains the queue, then closes the output
+    void encodeFrames() {
+        std::vector<uint8_t> rows(static_cast<size_t>(width_) * height_ * 4);
+        uint64_t index = 0;
+        while (true) {
+            std::unique_ptr<std::vector<uint8_t>> frame;
+            if (!ready_frames_.tryPop(frame)) {
+                uint64_t key = frames_ready_.prepareWait();
+                if (ready_frames_.tryPop(frame)) {
+                    frames_ready_.cancelWait();
+                } else if (!encoder_running_) {
+                    frames_ready_.cancelWait();
+                    break;
+                } else {
+                    frames_ready_.wait(key);
+                    continue;
+                }
+            }
+
+            size_t row_bytes = static_cast<size_t>(width_) * 4;
+            bool ok;
+            if (options_.format == CaptureFormat::PngSequence) {
+                for (int y = 0; y < height_; ++y) {
+                    const uint8_t* src = frame->data() + (height_ - 1 - y) * row_bytes;
+                    uint8_t* dst = rows.data() + y * static_cast<size_t>(width_) * 3;
+                    for (int x = 0; x < width_; ++x) {
+                        dst[x * 3 + 0] = src[x * 4 + 0];
+                        dst[x * 3 + 1] = src[x * 4 + 1];
+                        dst[x * 3 + 2] = src[x * 4 + 2];
+                    }
+                }
+                std::string filename = options_.output;
+                if (fileExtension(filename) != ".png") {
+                    char name[32];
+                    std::snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(index));
+                    filename = (std::filesystem::path(options_.output) / name).string();
+                }
+                ok = writePNG(filename, rows.data(), width_, height_);
+            } else {
+                for (int y = 0; y < height_; ++y)
+                    std::memcpy(rows.data() + y * row_bytes, frame->data() + (height_ - 1 - y) * row_bytes, row_bytes);
+                ok = std::fwrite(rows.data(), 1, rows.size(), file_) == rows.size();
+            }
+            if (!ok) std::cerr << "Error: Could not write captured frame " << index << std::endl;
+            ++index;
+            encoded_.fetch_add(1, std::memory_order_relaxed);
+            free_frames_.tryPush(std::move(frame));
+            frames_free_.notify();
+        }
+
+        std::unique_ptr<std::vector<uint8_t>> frame;
+        while (free_frames_.tryPop(frame)) {}
+        closeOutput();
+        Stats s = stats();
+        std::cout << "[Info] Capture finished: " << s.encoded << " frames written, "
+                  << s.dropped << " dropped" << std::endl;
+    }
+
+    CaptureOptions options_;
+    int width_ = 0, height_ = 0;
+    bool recording_ = false;
+    uint64_t requested_ = 0;
+    GLuint pbos_[Config::CAPTURE_PBO_COUNT] = {};
+    GLsync fences_[Config::CAPTURE_PBO_COUNT] = {};
+
+    MpmcRing<std::unique_ptr<std::vector<uint8_t>>> free_frames_{Config::CAPTURE_QUEUE_FRAMES};
+    MpmcRing<std::unique_ptr<std::vector<uint8_t>>> ready_frames_{Config::CAPTURE_QUEUE_FRAMES};
+    EventCount frames_ready_;
+    EventCount frames_free_;                // Signalled when the encoder returns a frame buffer
+    std::atomic<bool> encoder_running_{false};
+    std::thread encoder_;
+    std::FILE* file_ = nullptr;
+
+    std::atomic<uint64_t> captured_{0}, encoded_{0}, dropped_{0};
+};
+
+
+// ==========================
+// Input Trace Recording
+// ==========================
+
+// Camera parameters of the viewer (see setCamera())
+struct CameraState {
+    float target[3] = {0.0f, 0.0f, 0.0f};
+    float distance = Config::INITIAL_DISTANCE;
+    float azimuth = Config::INITIAL_AZIMUTH;
+    float elevation = Config::INITIAL_ELEVATION;
+    float pan_x = 0.0f, pan_y = 0.0f;
+    float fov = Config::INITIAL_FOV;
+};
+
+enum class TraceEventType : uint8_t {
+    AddPoints = 1,
+    SetPoints = 2,
+    ClearPoints = 3,
+    Camera = 4
+};
+
+// Trace file (.cptrace): TraceFileHeader, then one TraceRecord per call followed by its payload:
+//   AddPoints / SetPoints: count x 3 float positions, then depending on flags count x 3 uint8
+//                          colours, count float intensities and count uint8 classes
+//   Camera:                one CameraState
+//   ClearPoints:           nothing
+// All values are little endian; time_ns counts from the start of the recording.
+struct TraceFileHeader {
+    char magic[8] = {'C', 'P', 'T', 'R', 'A', 'C', 'E', '\0'};
+    uint32_t version = 1;
+    uint32_t reserved = 0;
+};
+
+struct TraceRecord {
+    uint8_t type = 0;                   // TraceEventType
+    uint8_t flags = 0;                  // TRACE_* channels present in the payload
+    uint8_t backpressure = 0;           // Backpressure of an AddPoints call
+    uint8_t reserved[5] = {0, 0, 0, 0, 0};
+    int64_t time_ns = 0;
+    uint64_t count = 0;                 // Points in the payload
+};
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord layout");
+
+constexpr uint8_t TRACE_COLORS = 1;
+constexpr uint8_t TRACE_INTENSITY = 2;
+constexpr uint8_t TRACE_CLASSIFICATION = 4;
+
+inline size_t tracePayloadBytes(const TraceRecord& record) {
+    if (record.type == static_cast<uint8_t>(TraceEventType::Camera)) return sizeof(CameraState);
+    size_t n = record.count;
+    return n * 3 * sizeof(float) + ((record.flags & TRACE_COLORS) ? n * 3 : 0) +
+           ((record.flags & TRACE_INTENSITY) ? n * sizeof(float) : 0) +
+           ((record.flags & TRACE_CLASSIFICATION) ? n : 0);
+}
+
+// Logs viewer input (point updates and camera changes) with timestamps to a trace file.
+// Callable from any thread; colours are stored as 8-bit values to keep the trace compact.
+// Callers only encode their record and queue it; a writer thread does the file I/O. When
+// TRACE_QUEUE_BYTES are queued, callers wait, so the trace stays complete.
+class TraceRecorder {
+public:
+    ~TraceRecorder() { close(); }
+
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    bool open(const std::string& filename) {
+        close();
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_ = std::fopen(filename.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "[Error] Cannot create trace file " << filename << std::endl;
+            return false;
+        }
+        buffer_.resize(Config::TRACE_BUFFER_BYTES);
+        std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+        TraceFileHeader header;
+        std::fwrite(&header, sizeof(header), 1, file_);
+        start_ = std::chrono::steady_clock::now();
+        running_ = true;
+        writer_ = std::thread(&TraceRecorder::writeRecords, this);
+        open_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Write the queued records and close the file
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_.store(false, std::memory_order_release);
+            running_ = false;
+        }
+        queue_cv_.notify_all();
+        if (writer_.joinable()) writer_.join();
+        if (file_) std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    void recordPoints(TraceEventType type, const PointView& points, Backpressure backpressure = Backpressure::Block) {
+        TraceRecord record;
+        record.type = static_cast<uint8_t>(type);
+        record.backpressure = static_cast<uint8_t>(backpressure);
+        record.count = points.count;
+        record.flags = (points.colors ? TRACE_COLORS : 0) | (points.intensity ? TRACE_INTENSITY : 0) |
+                       (points.classification ? TRACE_CLASSIFICATION : 0);
+
+        // Encode (and quantize the colours) on the calling thread, without any lock
+        size_t n = points.count;
+        std::vector<uint8_t> bytes(sizeof(record) + tracePayloadBytes(record));
+        uint8_t* out = bytes.data() + sizeof(record);
+        std::memcpy(out, points.positions, n * 3 * sizeof(float));
+        out += n * 3 * sizeof(float);
+        if (points.colors) {
+            parallelForChunks(n * 3, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    out[i] = static_cast<uint8_t>(std::clamp(points.colors[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+            });
+            out += n * 3;
+        }
+        if (points.intensity) {
+            std::memcpy(out, points.intensity, n * sizeof(float));
+            out += n * sizeof(float);
+        }
+        if (points.classification) std::memcpy(out, points.classification, n);
+        enqueue(record, std::move(bytes));
+    }
+
+    void recordClear() {
+        TraceRecord record;
+        record.type = static_cast<uint8_t>(TraceEventType::ClearPoints);
+        enqueue(record, std::vector<uint8_t>(sizeof(record)));
+    }
+
+    void recordCamera(const CameraState& camera) {
+        TraceRecord record;
+        record.type = static_cast<uint8_t>(TraceEventType::Camera);
+        std::vector<uint8_t> bytes(sizeof(record) + sizeof(camera));
+        std::memcpy(bytes.data() + sizeof(record), &camera, sizeof(camera));
+        enqueue(record, std::move(bytes));
+    }
+
+private:
+    // Timestamp the record and queue it; the timestamp is taken under the lock so records
+    // reach the file in time order
+    void enqueue(TraceRecord& record, std::vector<uint8_t>&& bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [&]() { return !running_ || queued_bytes_ < Config::TRACE_QUEUE_BYTES; });
+        if (!running_) return;
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        std::memcpy(bytes.data(), &record, sizeof(record));
+        queued_bytes_ += bytes.size();
+        queue_.push_back(std::move(bytes));
+        lock.unlock();
+        queue_cv_.notify_one();
+    }
+
+    // Writer thread: write queued records until closed and drained
+    void writeRecords() {
+        std::deque<std::vector<uint8_t>> records;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                queue_cv_.wait(lock, [&]() { return !running_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                records.swap(queue_);
+            }
+            size_t bytes = 0;
+            for (const auto& record : records) {
+                std::fwrite(record.data(), 1, record.size(), file_);
+                bytes += record.size();
+            }
+            records.clear();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queued_bytes_ -= bytes;
+            }
+            space_cv_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;                      // Guards the queue and running_
+    std::condition_variable queue_cv_, space_cv_;
+    std::deque<std::vector<uint8_t>> queue_;
+    size_t queued_bytes_ = 0;
+    bool running_ = false;
+    std::thread writer_;
+    std::FILE* file_ = nullptr;             // Written by the writer thread only
+    std::vector<char> buffer_;
+    std::atomic<bool> open_{false};
+    std::chrono::steady_clock::time_point start_;
+};
+
+// One decoded trace record
+struct TraceEvent {
+    TraceEventType type = TraceEventType::ClearPoints;
+    std::chrono::nanoseconds time{0};
+    Backpressure backpressure = Backpressure::Block;
+    PointBuffers points;                // AddPoints / SetPoints (colors empty if not recorded)
+    CameraState camera;                 // Camera
+};
+
+// Reads a trace file through a memory mapping, one record at a time
+class TraceReader {
+public:
+    bool open(const std::string& filename) {
+        if (!file_.open(filename)) {
+            std::cerr << "[Error] Cannot open trace file " << filename << std::endl;
+            return false;
+        }
+        TraceFileHeader expected, header;
+        if (file_.size() < sizeof(header)) return invalid(filename);
+        std::memcpy(&header, file_.data(), sizeof(header));
+        if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version)
+            return invalid(filename);
+        offset_ = sizeof(header);
+        return true;
+    }
+
+    // Decode the next record; false at the end of the trace (or at a truncated record)
+    bool next(TraceEvent& event) {
+        TraceRecord record;
+        if (offset_ + sizeof(record) > file_.size()) return false;
+        std::memcpy(&record, file_.data() + offset_, sizeof(record));
+        size_t payload = tracePayloadBytes(record);
+        if (record.count > file_.size() || offset_ + sizeof(record) + payload > file_.size()) {
+            std::cerr << "[Warning] Trace ends with a truncated record" << std::endl;
+            offset_ = file_.size();
+            return false;
+        }
+        const uint8_t* p = file_.data() + offset_ + sizeof(record);
+        offset_ += sizeof(record) + payload;
+
+        event.type = static_cast<TraceEventType>(record.type);
+        event.time = std::chrono::nanoseconds(record.time_ns);
+        event.backpressure = static_cast<Backpressure>(record.backpressure);
+        event.points = PointBuffers();
+        if (event.type == TraceEventType::Camera) {
+            std::memcpy(&event.camera, p, sizeof(event.camera));
+            return true;
+        }
+        if (event.type != TraceEventType::AddPoints && event.type != TraceEventType::SetPoints)
+            return true;
+
+        size_t n = record.count;
+        event.points.positions.resize(n * 3);
+        std::memcpy(event.points.positions.data(), p, n * 3 * sizeof(float));
+        p += n * 3 * sizeof(float);
+        if (record.flags & TRACE_COLORS) {
+            event.points.colors.resize(n * 3);
+            parallelForChunks(n * 3, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) event.points.colors[i] = p[i] / 255.0f;
+            });
+            p += n * 3;
+        }
+        if (record.flags & TRACE_INTENSITY) {
+            event.points.intensity.resize(n);
+            std::memcpy(event.points.intensity.data(), p, n * sizeof(float));
+            p += n * sizeof(float);
+        }
+        if (record.flags & TRACE_CLASSIFICATION)
+            event.points.classification.assign(p, p + n);
+        return true;
+    }
+
+private:
+    bool invalid(const std::string& filename) {
+        std::cerr << "[Error] " << filename << " is not a CloudPeek trace file" << std::endl;
+        file_.close();
+        return false;
+    }
+
+    MappedFile file_;
+    size_t offset_ = 0;
+};
+
+// ==========================
+// Split Viewports
+// ==========================
+
+// A region of the window with its own camera; all viewports draw the same GPU buffers
+struct Viewport {
+    float x = 0.0f, y = 0.0f, width = 1.0f, height = 1.0f; // Window fraction, origin bottom left
+    CameraState camera;
+};
+
+// Perspective view on the left, top and side views of the same target stacked on the right
+inline std::vector<Viewport> splitViewports(const CameraState& camera) {
+    std::vector<Viewport> viewports(3);
+    viewports[0] = { 0.0f, 0.0f, 0.6f, 1.0f, camera };
+    viewports[1] = { 0.6f, 0.5f, 0.4f, 0.5f, camera };
+    viewports[1].camera.elevation = 89.0f;
+    viewports[2] = { 0.6f, 0.0f, 0.4f, 0.5f, camera };
+    viewports[2].camera.elevation = 0.0f;
+    return viewports;
+}
+
+// ==========================
+// PointCloudViewer Class
+// ==========================
+class PointCloudViewer {
+public:
+    // Constructor with parameters. A headless viewer renders into an offscreen framebuffer
+    // of width x height behind a hidden window (for capture without a visible window).
+    PointCloudViewer(int width = Config::WINDOW_WIDTH, int height = Config::WINDOW_HEIGHT, const char* title = Config::WINDOW_TITLE,
+                     bool headless = false) :
+        width_(width), height_(height), title_(title), window_(nullptr), headless_(headless),
+        shader_program_(0),
+        grid_vbo_(0), grid_vao_(0), axes_vbo_(0), axes_vao_(0),
+        target_{0.0f, 0.0f, 0.0f},
+        distance_(Config::INITIAL_DISTANCE),
+        azimuth_(Config::INITIAL_AZIMUTH), elevation_(Config::INITIAL_ELEVATION),
+        pan_x_(0.0f), pan_y_(0.0f),
+        last_x_(static_cast<float>(width_) / 2.0f), last_y_(static_cast<float>(height_) / 2.0f),
+        first_mouse_(true),
+        fov_(Config::INITIAL_FOV),
         point_size_(Config::POINT_SIZE),
         is_running_(false),
         data_updated_(false)
@@ -427,18 +5236,341 @@ public:
         init();
     }
 
-    // Destructor
-    ~PointCloudViewer() {
-        cleanup();
+    // Destructor
+    ~PointCloudViewer() {
+        cleanup();
+    }
+
+    // Add points asynchronously. The conversion to the buffer layout happens on the calling
+    // thread; the batch is then handed over through a lock-free ring. backpressure decides
+    // what happens when the ring is full.
+    void addPoints(const std::vector<Point>& new_points, Backpressure backpressure = Backpressure::Block) {
+        PointBuffers buffers;
+        buffers.resize(new_points.size(), false);
+        for (size_t i = 0; i < new_points.size(); ++i) {
+            const Point& p = new_points[i];
+            buffers.positions[i * 3 + 0] = p.x;
+            buffers.positions[i * 3 + 1] = p.y;
+            buffers.positions[i * 3 + 2] = p.z;
+            buffers.colors[i * 3 + 0] = p.r / 255.0f;
+            buffers.colors[i * 3 + 1] = p.g / 255.0f;
+            buffers.colors[i * 3 + 2] = p.b / 255.0f;
+        }
+        addPoints(std::move(buffers), backpressure);
+    }
+
+    // Add points already in the buffer layout asynchronously (no conversion, no copy)
+    void addPoints(PointBuffers&& new_points, Backpressure backpressure = Backpressure::Block) {
+        if (trace_.isOpen()) trace_.recordPoints(TraceEventType::AddPoints, new_points, backpressure);
+        auto batch = std::make_unique<IngestBatch>();
+        batch->points = std::move(new_points);
+        batch->enqueued = std::chrono::steady_clock::now();
+
+        while (!ingest_queue_.tryPush(std::move(batch))) {
+            if (backpressure == Backpressure::DropNewest) {
+                countDroppedBatch(*batch);
+                return;
+            }
+            if (backpressure == Backpressure::DropOldest) {
+                std::unique_ptr<IngestBatch> oldest;
+                if (ingest_queue_.tryPop(oldest))
+                    countDroppedBatch(*oldest);
+                continue;
+            }
+            // Block: wait for the processing thread to make room
+            uint64_t key = ingest_space_.prepareWait();
+            if (ingest_queue_.sizeApprox() < ingest_queue_.capacity() || !is_running_) {
+                ingest_space_.cancelWait();
+                if (!is_running_) {
+                    countDroppedBatch(*batch); // The viewer stopped; nobody will make room
+                    return;
+                }
+                continue;
+            }
+            ingest_space_.wait(key);
+        }
+        ingest_ready_.notify();
+    }
+
+    // Append a processing stage (see cropStage(), voxelDownsampleStage(), ...) that every
+    // batch from addPoints() passes before it is stored. Batches run through the stages
+    // concurrently and are stored in the order they were added.
+    void addPipelineStage(const std::string& name, PointStage stage) {
+        pipeline_.addStage(name, std::move(stage));
+    }
+
+    void clearPipelineStages() {
+        pipeline_.clear();
+    }
+
+    // Per-stage batch and point counts, latency and throughput
+    std::vector<StageStats> pipelineStats() const {
+        return pipeline_.stats();
+    }
+
+    // Names of the per-point channels the points can be coloured by: intensity, classification,
+    // cluster and time when stored, then the attributes the loaders or producers provided
+    std::vector<std::string> colorAttributes() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        std::vector<std::string> names;
+        if (!point_intensity_.empty()) names.push_back("intensity");
+        if (!point_classification_.empty()) names.push_back("classification");
+        if (!point_cluster_.empty()) names.push_back("cluster");
+        if (!point_time_.empty()) names.push_back("time");
+        for (const AttributeChannel& channel : point_attributes_) names.push_back(channel.name);
+        return names;
+    }
+
+    // Colour the points by a channel (empty name: their own colours), blue at its minimum to red
+    // at its maximum. Only that channel is uploaded, as one float per point; the stored points
+    // and their other GPU buffers are left alone.
+    bool setColorAttribute(const std::string& name) {
+        if (!name.empty()) {
+            auto names = colorAttributes();
+            if (std::find(names.begin(), names.end(), name) == names.end()) {
+                std::cerr << "Error: The points have no attribute " << name << '\n';
+                return false;
+            }
+        }
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        color_attribute_ = name;
+        updateColorRange();
+        for (auto& chunk : chunks_) chunk->scalar_stale = true;
+        return true;
+    }
+
+    std::string colorAttribute() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        return color_attribute_;
+    }
+
+    // Hide points labelled as ground (see groundSegmentationStage()) in the shader, without
+    // touching the stored points or their GPU buffers
+    void setGroundHidden(bool hidden) {
+        hide_ground_ = hidden;
+    }
+
+    bool groundHidden() const {
+        return hide_ground_;
+    }
+
+    // Show only the points inside an oriented box and/or in front of up to MAX_CLIP_PLANES
+    // planes. The test runs in the point shader, so moving the region re-uploads nothing.
+    void setClipRegion(const ClipRegion& region) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        clip_ = region;
+        if (clip_.planes.size() > Config::MAX_CLIP_PLANES) {
+            std::cerr << "Warning: Only the first " << Config::MAX_CLIP_PLANES << " clip planes are used\n";
+            clip_.planes.resize(Config::MAX_CLIP_PLANES);
+        }
+        cluster_boxes_dirty_ = true; // The box outline is drawn with the cluster boxes
+    }
+
+    ClipRegion clipRegion() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        return clip_;
+    }
+
+    // Copy the stored points inside a clip region into a new cloud, filtering in parallel.
+    // Chunks whose bounds lie entirely outside (or inside) the region are skipped (or
+    // copied) without testing their points. The chunks are classified under data_mutex_;
+    // counting and copying take the lock per slice of blocks, like snapshotPoints().
+    PointBuffers extractRegion(const ClipRegion& region) {
+        // Blocks of slots: the GPU chunks with their bounds while these are current
+        struct Block { size_t first, last; ClipOverlap overlap; size_t offset; };
+        size_t slice = std::max<size_t>(Config::SNAPSHOT_SLICE_POINTS / Config::GPU_CHUNK_POINTS, 1);
+        for (int attempt = 0; ; ++attempt) {
+            bool whole = attempt == Config::SNAPSHOT_RETRIES;
+            std::unique_lock<std::mutex> lock(data_mutex_);
+            uint64_t generation = slots_generation_;
+            std::vector<Block> blocks;
+            auto live = liveRanges();
+            for (size_t first = 0; first < slotCount(); first += Config::GPU_CHUNK_POINTS) {
+                size_t last = std::min(first + Config::GPU_CHUNK_POINTS, slotCount());
+                ClipOverlap overlap = ClipOverlap::Partial;
+                size_t c = first / Config::GPU_CHUNK_POINTS;
+                if (!data_updated_ && c < chunks_.size())
+                    overlap = region.classify(chunks_[c]->bounds_min, chunks_[c]->bounds_max);
+                if (overlap == ClipOverlap::Outside) continue;
+                for (const auto& range : live) {
+                    size_t begin = std::max(first, range.first), end = std::min(last, range.second);
+                    if (begin < end) blocks.push_back({ begin, end, overlap, 0 });
+                }
+            }
+            PointBuffers points;
+            std::copy(points_origin_, points_origin_ + 3, points.origin);
+            bool intensity = !point_intensity_.empty(), classification = !point_classification_.empty();
+            for (const AttributeChannel& channel : point_attributes_) points.attributes.push_back({ channel.name, channel.type, {} });
+            if (!whole) lock.unlock();
+
+            // Age order: the older ring range first
+            if (live[1].second > 0)
+                std::stable_partition(blocks.begin(), blocks.end(), [&](const Block& b) { return b.first >= live[0].first; });
+            // Run fn over the blocks [begin, end) in parallel
+            auto forBlocks = [&](auto fn) {
+                return [&, fn](size_t begin, size_t end) {
+                    std::vector<size_t> indices(end - begin);
+                    std::iota(indices.begin(), indices.end(), begin);
+                    std::for_each(std::execution::par, indices.begin(), indices.end(), fn);
+                };
+            };
+            auto run = [&](auto&& fn) {
+                if (!whole) return forEachLockedSlice(generation, blocks.size(), slice, fn);
+                fn(size_t{0}, blocks.size());
+                return true;
+            };
+
+            // Count, then copy each block to its offset
+            std::vector<size_t> counts(blocks.size());
+            bool current = run(forBlocks([&](size_t b) {
+                const Block& block = blocks[b];
+                if (block.overlap == ClipOverlap::Inside) {
+                    counts[b] = block.last - block.first;
+                    return;
+                }
+                size_t n = 0;
+                for (size_t i = block.first; i < block.last; ++i)
+                    n += region.contains(&point_cloud_[i * 3]);
+                counts[b] = n;
+            }));
+            if (!current) continue;
+            size_t total = 0;
+            for (size_t b = 0; b < blocks.size(); ++b) {
+                blocks[b].offset = total;
+                total += counts[b];
+            }
+            points.resize(total, intensity, classification);
+            current = run(forBlocks([&](size_t b) {
+                const Block& block = blocks[b];
+                size_t out = block.offset;
+                for (size_t i = block.first; i < block.last; ++i) {
+                    if (block.overlap != ClipOverlap::Inside && !region.contains(&point_cloud_[i * 3])) continue;
+                    std::copy_n(&point_cloud_[i * 3], 3, &points.positions[out * 3]);
+                    std::copy_n(&point_colors_[i * 3], 3, &points.colors[out * 3]);
+                    if (intensity) points.intensity[out] = point_intensity_[i];
+                    if (classification) points.classification[out] = point_classification_[i];
+                    for (size_t a = 0; a < points.attributes.size(); ++a) points.attributes[a].copyFrom(point_attributes_[a], i, out, 1);
+                    ++out;
+                }
+            }));
+            if (current) return points;
+        }
+    }
+
+    // Bound the number and age of points kept; the oldest points are evicted, decimated or
+    // expired so a live feed runs at constant memory
+    void setCapacity(const CapacityOptions& options) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        capacity_ = options;
+        if (capacity_.max_points && ring_count_ > capacity_.max_points) {
+            ingest_stats_.points_evicted += ring_count_ - capacity_.max_points;
+            dropOldest(ring_count_ - capacity_.max_points);
+        }
+        linearizeStorage();
+        data_updated_ = true;
+    }
+
+    IngestStats ingestStats() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        IngestStats stats = ingest_stats_;
+        stats.batches_dropped = batches_dropped_.load();
+        stats.points_dropped = points_dropped_.load();
+        stats.points_stored = ring_count_;
+        return stats;
+    }
+
+    // Register a sensor feeding timestamped batches; its batches are merged with those of the
+    // other sources in time order (see SourceMerger) before they enter the pipeline
+    SourceId addSource(const std::string& name) {
+        return merger_.addSource(name);
+    }
+
+    // Add a batch of a source captured at timestamp (one clock for all sources, increasing per
+    // source). Returns false if the batch was older than merged output already published.
+    bool addPoints(SourceId source, std::chrono::nanoseconds timestamp, PointBuffers&& points) {
+        return merger_.push(source, timestamp, std::move(points));
+    }
+
+    // Longest a batch waits for older batches of other sources (one frame by default)
+    void setReorderWindow(std::chrono::nanoseconds window) {
+        merger_.setReorderWindow(window);
+    }
+
+    // Per-source batch counts, drops, lag behind the newest source and merge wait
+    std::vector<SourceStats> sourceStats() const {
+        return merger_.stats();
+    }
+
+    // Consume point frames from a shared-memory ring (see SharedPointRing.hpp) created by an
+    // external producer process. Call before run(); the viewer attaches when the producer
+    // appears and re-attaches if it restarts.
+    void openSharedMemory(const std::string& name) {
+        shm_name_ = name;
+    }
+
+    // Record frames asynchronously (PBO readback, background encoder). Takes effect on the
+    // next rendered frame; a headless viewer stops once max_frames have been captured.
+    void startRecording(const CaptureOptions& options) {
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        pending_capture_ = std::make_unique<CaptureOptions>(options);
+        stop_capture_ = false;
+    }
+
+    void stopRecording() {
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        pending_capture_.reset();
+        stop_capture_ = true;
+    }
+
+    // Save the next rendered frame as a PNG file
+    void saveScreenshot(const std::string& filename) {
+        CaptureOptions options;
+        options.output = filename;
+        options.max_frames = 1;
+        startRecording(options);
     }
 
-    // Add points asynchronously
-    void addPoints(const std::vector<Point>& new_points) {
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            point_queue_.emplace(new_points);
-        }
-        queue_cond_var_.notify_one();
+    FrameRecorder::Stats captureStats() const {
+        return recorder_.stats();
+    }
+
+    // Orbit the camera around the target (degrees per second), e.g. for fly-through videos
+    void setAutoRotate(float degrees_per_second) {
+        auto_rotate_ = degrees_per_second;
+    }
+
+    // Log every addPoints/setPoints/clearPoints call and camera change to a trace file that
+    // replays the session later (see TraceReader and --replay in main.cpp)
+    bool startTrace(const std::string& filename) {
+        camera_traced_ = false;
+        return trace_.open(filename);
+    }
+
+    void stopTrace() {
+        trace_.close();
+    }
+
+    // Move the camera; applied by the render thread at the start of the next frame
+    void setCamera(const CameraState& camera) {
+        std::lock_guard<std::mutex> lock(camera_mutex_);
+        pending_camera_ = std::make_unique<CameraState>(camera);
+    }
+
+    // Split the window into viewports with their own cameras (e.g. splitViewports()), or go
+    // back to one view with an empty list. Mouse and keys steer the viewport under the cursor.
+    void setViewports(const std::vector<Viewport>& viewports) {
+        std::lock_guard<std::mutex> lock(camera_mutex_);
+        pending_viewports_ = std::make_unique<std::vector<Viewport>>(viewports);
+    }
+
+    // Wall time of each pass through the render loop (input, drawing, buffer swap)
+    LatencyHistogram::Snapshot frameTimes() const {
+        return frame_times_.snapshot();
+    }
+
+    // Time from addPoints() until the batch is part of the displayed cloud
+    LatencyHistogram::Snapshot ingestionLatency() const {
+        return ingestion_latency_.snapshot();
     }
 
     // Main loop
@@ -446,25 +5578,38 @@ public:
         is_running_ = true;
         // Start the data processing thread
         std::thread data_thread(&PointCloudViewer::processData, this);
+        std::thread shm_thread;
+        if (!shm_name_.empty())
+            shm_thread = std::thread(&PointCloudViewer::consumeSharedMemory, this);
+        std::thread merge_thread(&PointCloudViewer::publishMergedBatches, this);
 
         // Start the rendering loop
-        while (!glfwWindowShouldClose(window_) && is_running_) {
+        while ((headless_ || !glfwWindowShouldClose(window_)) && is_running_) {
+            auto frame_start = std::chrono::steady_clock::now();
             processInput(window_);
             render();
             glfwPollEvents();
+            frame_times_.record(std::chrono::steady_clock::now() - frame_start);
+            if (trace_.isOpen()) traceCamera();
         }
 
         // Stop the data processing thread
         is_running_ = false;
-        queue_cond_var_.notify_one();
+        ingest_ready_.notify();
+        ingest_space_.notify();
+        merger_.close();
+        merge_thread.join();
         if (data_thread.joinable())
             data_thread.join();
+        if (shm_thread.joinable())
+            shm_thread.join();
     }
 
     // Stop the viewer
     void stop() {
         is_running_ = false;
-        queue_cond_var_.notify_one();
+        ingest_ready_.notify();
+        ingest_space_.notify();
     }
 
     // Check if the viewer is running
@@ -483,45 +5628,210 @@ public:
 
     // Method to clear all points
     void clearPoints() {
+        if (trace_.isOpen()) trace_.recordClear();
         std::lock_guard<std::mutex> lock(data_mutex_);
         point_cloud_.clear();
         point_colors_.clear();
-        data_updated_ = true;
-        
-        // Optionally, update the OpenGL buffers immediately
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, color_vbo_);
-        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        point_intensity_.clear();
+        point_classification_.clear();
+        point_cluster_.clear();
+        point_time_.clear();
+        point_attributes_.clear();
+        std::fill(points_origin_, points_origin_ + 3, 0.0);
+        resetRing();
+        data_updated_ = true; // The render thread releases the GPU chunks
     }
 
-    // Replace currently displayed points
+    // Replace currently displayed points (converted and traced before the data lock is taken)
     void setPoints(const std::vector<Point>& new_points) {
-        std::lock_guard<std::mutex> lock(data_mutex_);
-        point_cloud_.clear();
-        point_colors_.clear();
-        point_cloud_.reserve(new_points.size() * 3);
-        point_colors_.reserve(new_points.size() * 3);
-        for (const auto& p : new_points) {
-            point_cloud_.push_back(p.x);
-            point_cloud_.push_back(p.y);
-            point_cloud_.push_back(p.z);
-            point_colors_.push_back(p.r / 255.0f);
-            point_colors_.push_back(p.g / 255.0f);
-            point_colors_.push_back(p.b / 255.0f);
+        PointBuffers buffers;
+        buffers.resize(new_points.size(), false);
+        for (size_t i = 0; i < new_points.size(); ++i) {
+            const Point& p = new_points[i];
+            buffers.positions[i * 3 + 0] = p.x;
+            buffers.positions[i * 3 + 1] = p.y;
+            buffers.positions[i * 3 + 2] = p.z;
+            buffers.colors[i * 3 + 0] = p.r / 255.0f;
+            buffers.colors[i * 3 + 1] = p.g / 255.0f;
+            buffers.colors[i * 3 + 2] = p.b / 255.0f;
         }
+        setPoints(std::move(buffers));
+    }
+
+    // Replace currently displayed points with buffers already in the viewer layout (no conversion)
+    void setPoints(PointBuffers&& buffers) {
+        if (trace_.isOpen()) trace_.recordPoints(TraceEventType::SetPoints, buffers);
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        point_cloud_ = std::move(buffers.positions);
+        point_colors_ = std::move(buffers.colors);
+        point_intensity_ = std::move(buffers.intensity);
+        point_classification_ = std::move(buffers.classification);
+        point_cluster_ = std::move(buffers.cluster);
+        point_attributes_ = std::move(buffers.attributes);
+        std::copy(buffers.origin, buffers.origin + 3, points_origin_);
+        point_time_.clear();
+        resetRing();
+        data_updated_ = true;
+    }
+
+    // Load a point cloud file or KITTI drive on a background thread, adding its points chunk
+    // by chunk as they are decoded. The handle reports progress and cancels the load.
+    std::shared_ptr<LoadHandle> loadAsync(const std::string& path) {
+        auto handle = std::make_shared<LoadHandle>();
+        std::thread thread([this, path, handle] {
+            // Hold the points back until the processing thread is running
+            while (!is_running_ && !handle->isCancelled())
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            bool ok = false;
+            try { // The completion promise must be set whatever the decoders do
+                ok = !handle->isCancelled() &&
+                    streamPointCloud(path, *handle, [this, &handle](PointBuffers&& chunk) {
+                        if (!is_running_) handle->cancel(); // The viewer closed; stop decoding
+                        else addPoints(std::move(chunk));
+                    });
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << '\n';
+            }
+            if (!ok && !handle->isCancelled())
+                std::cerr << "Error: Failed to load " << path << '\n';
+            handle->finish(ok);
+        });
+        trackLoad(handle, std::move(thread));
+        return handle;
+    }
+
+    // Write the stored points (positions, colours, intensity, classification) to a PCD or PLY
+    // file on a background thread. Only the slices of the copy of the points hold the data lock;
+    // encoding and writing run without it, so rendering continues. Backspace cancels like a load.
+    std::shared_ptr<LoadHandle> exportAsync(const std::string& path, PointFileFormat format) {
+        auto handle = std::make_shared<LoadHandle>();
+        std::thread thread([this, path, format, handle] {
+            auto start = std::chrono::steady_clock::now();
+            PointBuffers points = snapshotPoints();
+            bool ok = !handle->isCancelled() && writePointCloud(path, points, format, handle.get());
+            if (ok) {
+                std::cout << "[Info] Exported " << points.size() << " points to " << path << " in "
+                          << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+            }
+            handle->finish(ok);
+        });
+        trackLoad(handle, std::move(thread));
+        return handle;
+    }
+
+    // Replace the cloud by the points inside the current clip region, on a background thread
+    std::shared_ptr<LoadHandle> extractRegionAsync() {
+        auto handle = std::make_shared<LoadHandle>();
+        std::thread thread([this, handle] {
+            ClipRegion region = clipRegion();
+            bool ok = region.active() && !handle->isCancelled();
+            if (ok) {
+                PointBuffers points = extractRegion(region);
+                handle->advance(0, points.size());
+                std::cout << "[Info] Extracted " << points.size() << " points inside the clip region" << std::endl;
+                if (!handle->isCancelled()) setPoints(std::move(points));
+            }
+            handle->finish(ok);
+        });
+        trackLoad(handle, std::move(thread));
+        return handle;
+    }
+
+    // Cancel every running asynchronous load or export (points already loaded stay)
+    void cancelLoads() {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        for (auto& load : loads_) load.first->cancel();
+    }
+
+    // Upload a whole event recording once, with one timestamp per point relative to
+    // time_base (e.g. milliseconds since the first event, time_base being that event's
+    // time). Only events inside the time window are drawn; the window is a shader uniform,
+    // so scrubbing or resizing it costs no CPU work or uploads. Batches added later keep
+    // their timestamps if they carry a "time" attribute on the clock of time_base; points
+    // without one are stamped with the newest timestamp so far.
+    void setEventTimeline(PointBuffers&& buffers, std::vector<float>&& timestamps, double time_base = 0.0) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        point_cloud_ = std::move(buffers.positions);
+        point_colors_ = std::move(buffers.colors);
+        point_intensity_ = std::move(buffers.intensity);
+        point_classification_ = std::move(buffers.classification);
+        point_cluster_ = std::move(buffers.cluster);
+        point_attributes_ = std::move(buffers.attributes);
+        std::copy(buffers.origin, buffers.origin + 3, points_origin_);
+        point_time_ = std::move(timestamps);
+        point_time_.resize(point_cloud_.size() / 3, 0.0f);
+        timeline_.enabled = !point_time_.empty();
+        timeline_.base = time_base;
+        timeline_.first = timeline_.enabled ? *std::min_element(point_time_.begin(), point_time_.end()) : 0.0f;
+        timeline_.last = timeline_.enabled ? *std::max_element(point_time_.begin(), point_time_.end()) : 0.0f;
+        resetRing();
         data_updated_ = true;
     }
 
+    // Show events with t_start <= t <= t_end; with decay > 0 older events fade out as
+    // exp(-(t_end - t) / decay)
+    void setTimeWindow(float t_start, float t_end, float decay = 0.0f) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        timeline_.start = t_start;
+        timeline_.end = t_end;
+        timeline_.decay = decay;
+    }
+
+    // Advance the time window by speed times the real elapsed time (0 pauses playback)
+    void setTimelinePlayback(float speed) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        timeline_.speed = speed;
+    }
+
+    // Show the cloud as a bird's-eye-view raster (per-cell density, max z or mean intensity)
+    // instead of points; drawing then costs the same for any number of points
+    void setRasterMode(bool enabled, const RasterOptions& options = RasterOptions()) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        if (options.cell_size != raster_options_.cell_size) invalidateRaster();
+        raster_options_ = options;
+        raster_mode_ = enabled;
+        if (!enabled) {
+            raster_.clear();
+            if (raster_job_) raster_job_->stale = true;
+        }
+    }
+
+    // Stream an out-of-core tile file (see buildTilesFromPCD) instead of holding it in memory
+    bool openTiles(const std::string& filename) {
+        auto tiles = std::make_unique<TiledPointCloud>();
+        if (!tiles->open(filename, &gpu_budget_))
+            return false;
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        pending_tiles_ = std::move(tiles);
+        return true;
+    }
+
+    // Budget for all evictable GPU point buffers (point chunks and tiles), in bytes
+    void setGpuMemoryBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        gpu_budget_.setBudget(bytes);
+    }
+
+    // GPU memory residency and eviction statistics
+    GpuMemoryBudget::Stats gpuMemoryStats() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        return gpu_budget_.stats();
+    }
+
+    // Residency statistics of the streamed tile file (all zero if none is open)
+    TiledPointCloud::Stats tileStats() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        return tiled_cloud_ ? tiled_cloud_->stats() : TiledPointCloud::Stats();
+    }
+
 private:
     // Window parameters
     int width_, height_;
     const char* title_;
     GLFWwindow* window_;
+    bool headless_;
 
     // OpenGL objects
-    GLuint vbo_, vao_, color_vbo_;
     GLuint shader_program_;
 
     // Grid and Axes
@@ -535,13 +5845,148 @@ private:
     // Point cloud data
     std::vector<float> point_cloud_;    // x, y, z
     std::vector<float> point_colors_;   // r, g, b
+    std::vector<float> point_intensity_; // Per-point intensity/reflectance, empty if unknown
+    std::vector<uint8_t> point_classification_; // Per-point class, empty if unknown
+    std::vector<uint32_t> point_cluster_; // Per-point cluster id, empty if not clustered
+    std::vector<float> point_time_;     // Per-point timestamp of an event timeline, empty otherwise
+    std::vector<AttributeChannel> point_attributes_; // Further named channels, slot-aligned
+    double points_origin_[3] = {0.0, 0.0, 0.0};     // World position of the local (0,0,0) (LAS)
     std::mutex data_mutex_;
+
+    // Colouring by a channel (guarded by data_mutex_). Values are uploaded relative to
+    // scalar_offset_ so large ones (e.g. GPS time) keep their precision as floats.
+    std::string color_attribute_;       // Empty: the stored colours
+    double scalar_offset_ = 0.0;
+    float color_range_[2] = { 0.0f, 0.0f }; // Relative to scalar_offset_
+    std::vector<float> scalar_staging_;
+
+    // Event timeline window (uniforms of the point shader), guarded by data_mutex_
+    struct TimelineState {
+        bool enabled = false;
+        double base = 0.0;                  // Clock value of timestamp 0; point_time_ is relative to it
+        float first = 0.0f, last = 0.0f;    // Timestamp range of the recording
+        float start = 0.0f, end = 0.0f;     // Displayed window
+        float decay = 0.0f;
+        float speed = 1.0f;                 // Playback rate (timestamp units per millisecond)
+    } timeline_;
     std::atomic<bool> data_updated_;
 
+    // Storage bounds. point_cloud_ and the attribute vectors hold slots; the displayed points
+    // are the ring_count_ slots starting at ring_tail_, wrapping around once a bounded cloud
+    // has grown to its capacity. batch_spans_ records the age of consecutive runs of them.
+    struct BatchSpan {
+        size_t count;
+        std::chrono::steady_clock::time_point time;
+    };
+    CapacityOptions capacity_;
+    size_t ring_tail_ = 0;
+    size_t ring_count_ = 0;
+    uint64_t slots_generation_ = 0;                     // Bumped whenever displayed slots change
+    std::deque<BatchSpan> batch_spans_;                 // Oldest first
+    IngestStats ingest_stats_;
+    std::atomic<uint64_t> batches_dropped_{0};
+    std::atomic<uint64_t> points_dropped_{0};
+
+    // GPU copy of the point cloud, split into chunks of GPU_CHUNK_POINTS points that are
+    // uploaded when visible and evicted least recently used under the memory budget
+    struct PointChunk {
+        size_t first = 0, count = 0;        // Point range in point_cloud_
+        float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+        float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+        GLuint vao = 0, vbo = 0, color_vbo = 0, time_vbo = 0, class_vbo = 0, scalar_vbo = 0;
+        float time_min = 0.0f, time_max = 0.0f; // Timestamp range (event timelines)
+        GpuMemoryBudget::Handle gpu = 0;
+        size_t gpu_capacity = 0;            // Points the GPU buffers can hold
+        size_t dirty_first = 0, dirty_last = 0; // Chunk-relative span to re-upload
+        size_t rewritten = 0;               // Slots written since the bounds were last computed exactly
+        bool stale = true;                  // GPU contents no longer match point_cloud_
+        bool scalar_stale = false;          // Only the colour attribute changed
+    };
+    std::vector<std::unique_ptr<PointChunk>> chunks_;   // Guarded by data_mutex_
+    std::vector<std::pair<size_t, size_t>> dirty_ranges_; // Slots written since the last frame
+    bool layout_changed_ = false;           // Slots moved or replaced: rebuild all chunks
+    GpuMemoryBudget gpu_budget_{Config::GPU_MEMORY_BUDGET_BYTES}; // Guarded by data_mutex_
+    uint64_t frame_index_ = 0;
+
+    // Bird's-eye-view raster: the grid follows the stored slots (guarded by data_mutex_),
+    // its texture is updated by the render thread
+    bool raster_mode_ = false;
+    RasterOptions raster_options_;
+    DensityRaster raster_;
+    // A raster rebuild binning a copy of the points on a worker; the slots stored and dropped
+    // meanwhile are applied to its result before it replaces raster_
+    struct RasterJob {
+        std::shared_ptr<const std::vector<float>> positions, intensity; // Age order
+        std::future<DensityRaster> result;
+        size_t added = 0;                   // Points stored since the copy
+        size_t removed = 0;                 // Points dropped from the old end since the copy
+        bool stale = false;                 // Points moved or replaced: the result is discarded
+    };
+    std::unique_ptr<RasterJob> raster_job_;
+    int raster_discards_ = 0;               // Stale results in a row
+    GLuint raster_shader_program_ = 0;
+    GLuint raster_vbo_ = 0, raster_vao_ = 0, raster_texture_ = 0;
+    int raster_texture_size_[2] = {0, 0};
+    GpuMemoryBudget::Handle raster_gpu_ = 0;
+    std::vector<float> raster_texels_;
+
+    // Bounding boxes of the latest clusters, drawn as lines with the axes shader
+    std::vector<ClusterBox> cluster_boxes_;        // Guarded by data_mutex_
+    bool cluster_boxes_dirty_ = false;             // Guarded by data_mutex_
+    GLuint cluster_vbo_ = 0, cluster_vao_ = 0;
+    GLsizei cluster_vertices_ = 0;
+    GpuMemoryBudget::Handle cluster_gpu_ = 0;
+
+    // Out-of-core tile streaming (swapped in on the render thread, which owns the GL objects)
+    std::unique_ptr<TiledPointCloud> tiled_cloud_;
+    std::unique_ptr<TiledPointCloud> pending_tiles_;
+
+    // Shared-memory ingestion endpoint
+    std::string shm_name_;
+    SourceMerger merger_;                // Timestamp-ordered merge of addSource() feeds
+
+    // Frame capture (the recorder is driven by the render thread)
+    FrameRecorder recorder_;
+    std::mutex capture_mutex_;
+    std::unique_ptr<CaptureOptions> pending_capture_;   // Guarded by capture_mutex_
+    bool stop_capture_ = false;                         // Guarded by capture_mutex_
+    bool capture_ends_run_ = false;                     // Headless recording with a frame limit
+    bool screenshot_pressed_ = false;
+    bool record_pressed_ = false;
+    std::atomic<float> auto_rotate_{0.0f};
+    GLuint offscreen_fbo_ = 0, offscreen_color_ = 0, offscreen_depth_ = 0;
+
+    // Input trace and replay (the render thread records and applies camera changes)
+    TraceRecorder trace_;
+    CameraState traced_camera_;
+    bool camera_traced_ = false;
+    std::mutex camera_mutex_;
+    std::unique_ptr<CameraState> pending_camera_;      // Guarded by camera_mutex_
+
+    // Split viewports (render thread); the camera members hold the active viewport's camera
+    std::vector<Viewport> viewports_;
+    size_t active_viewport_ = 0;
+    std::unique_ptr<std::vector<Viewport>> pending_viewports_; // Guarded by camera_mutex_
+    bool split_pressed_ = false;         // Debounce split view key
+    bool export_pressed_ = false;        // Debounce export key
+    LatencyHistogram frame_times_;
+
+    // Progressive loads started by loadAsync()
+    std::mutex load_mutex_;
+    std::list<std::pair<std::shared_ptr<LoadHandle>, std::thread>> loads_;  // Loads and exports, guarded by load_mutex_
+    bool cancel_pressed_ = false;
+
     // Asynchronous data streaming
-    std::queue<std::vector<Point>> point_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cond_var_;
+    MpmcRing<std::unique_ptr<IngestBatch>> ingest_queue_{Config::INGEST_QUEUE_CAPACITY};
+    EventCount ingest_ready_;   // Signalled when a batch is queued
+    EventCount ingest_space_;   // Signalled when the processing thread frees a slot
+    BatchPipeline pipeline_;
+    std::atomic<bool> hide_ground_{false};
+    ClipRegion clip_;                    // Guarded by data_mutex_
+    float clip_yaw_ = 0.0f;              // Yaw of the interactive clip box (render thread)
+    bool clip_pressed_ = false;          // Debounce clip box key
+    bool extract_pressed_ = false;       // Debounce ROI extraction key
+    LatencyHistogram ingestion_latency_;
     std::atomic<bool> is_running_;
 
     // Camera parameters for Arcball Camera
@@ -572,14 +6017,37 @@ private:
     bool toggle_pressed_ = false;  // Debounce toggle key
     bool middle_button_pressed_ = false; // Track middle mouse drag
     bool right_button_pressed_ = false;  // Track right mouse drag for panning
+    bool play_pressed_ = false;          // Debounce timeline play/pause key
+    bool raster_pressed_ = false;        // Debounce raster mode key
+    bool channel_pressed_ = false;       // Debounce raster channel key
+    bool ground_pressed_ = false;        // Debounce ground visibility key
+    bool color_pressed_ = false;         // Debounce colour attribute key
+    float paused_speed_ = 1.0f;          // Playback speed restored when resuming
+    float frame_dt_ = 0.0f;              // Seconds since the previous frame
 
     // Vertex Shader Source
     const char* vertex_shader_src_ = R"(
         #version 330 core
         layout(location = 0) in vec3 aPos;
         layout(location = 1) in vec3 aColor;
+        layout(location = 2) in float aTime;
+        layout(location = 3) in float aClass;
+        layout(location = 4) in float aScalar;
         
         uniform mat4 MVP;
+        uniform bool uTimeline;
+        uniform float uTimeStart;
+        uniform float uTimeEnd;
+        uniform float uDecay;
+        uniform float uHiddenClass;
+        uniform bool uClipBox;
+        uniform vec3 uBoxCenter;
+        uniform mat3 uBoxAxes;      // Columns: box axes
+        uniform vec3 uBoxHalf;
+        uniform int uClipPlaneCount;
+        uniform vec4 uClipPlanes[6];
+        uniform bool uColorByScalar;
+        uniform vec2 uScalarRange;
         
         out vec3 ourColor;
         
@@ -587,6 +6055,25 @@ private:
             gl_Position = MVP * vec4(aPos, 1.0);
             ourColor = aColor;
             gl_PointSize = 2.0;
+            if (uColorByScalar) {
+                // Hue from blue (minimum) to red (maximum), like the distance colouring
+                float t = clamp((aScalar - uScalarRange.x) / max(uScalarRange.y - uScalarRange.x, 1e-6), 0.0, 1.0);
+                ourColor = clamp(abs(mod((1.0 - t) * 0.66 * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+            }
+            if (uTimeline) {
+                // Outside the window: move the point out of the clip volume
+                if (aTime < uTimeStart || aTime > uTimeEnd)
+                    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+                else if (uDecay > 0.0)
+                    ourColor = mix(vec3(0.1), ourColor, exp(-(uTimeEnd - aTime) / uDecay));
+            }
+            if (uHiddenClass >= 0.0 && abs(aClass - uHiddenClass) < 0.5)
+                gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            if (uClipBox && any(greaterThan(abs((aPos - uBoxCenter) * uBoxAxes), uBoxHalf)))
+                gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            for (int i = 0; i < uClipPlaneCount; ++i)
+                if (dot(uClipPlanes[i].xyz, aPos) + uClipPlanes[i].w < 0.0)
+                    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
         }
     )";
 
@@ -648,6 +6135,48 @@ private:
         }
     )";
 
+    // Raster Shader Sources: a unit quad scaled to the grid, coloured with the same
+    // red-to-blue hue gradient as distanceToRGB
+    const char* raster_vertex_shader_src_ = R"(
+        #version 330 core
+        layout(location = 0) in vec2 aCorner;
+        
+        uniform mat4 MVP;
+        uniform vec2 uOrigin;
+        uniform vec2 uExtent;
+        uniform float uHeight;
+        
+        out vec2 texCoord;
+        
+        void main(){
+            texCoord = aCorner;
+            gl_Position = MVP * vec4(uOrigin + aCorner * uExtent, uHeight, 1.0);
+        }
+    )";
+
+    const char* raster_fragment_shader_src_ = R"(
+        #version 330 core
+        in vec2 texCoord;
+        out vec4 FragColor;
+        
+        uniform sampler2D uRaster;  // count, max z, mean intensity
+        uniform int uChannel;
+        uniform vec2 uRange;
+        
+        vec3 colormap(float t){
+            float h = (1.0 - t) * 0.66 * 6.0;
+            return clamp(vec3(abs(h - 3.0) - 1.0, 2.0 - abs(h - 2.0), 2.0 - abs(h - 4.0)), 0.0, 1.0);
+        }
+        
+        void main(){
+            vec3 cell = texture(uRaster, texCoord).rgb;
+            if (cell.r < 0.5) discard; // Empty cell
+            float value = uChannel == 0 ? log(1.0 + cell.r) : (uChannel == 1 ? cell.g : cell.b);
+            float t = clamp((value - uRange.x) / max(uRange.y - uRange.x, 1e-6), 0.0, 1.0);
+            FragColor = vec4(colormap(t), 1.0);
+        }
+    )";
+
     // Initialize GLFW, OpenGL, Shaders, Buffers
     void init() {
         // Initialize GLFW
@@ -665,7 +6194,8 @@ private:
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // For macOS
     #endif
 
-        // Create window
+        // Create window (hidden when headless)
+        if (headless_) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
         window_ = glfwCreateWindow(width_, height_, title_, NULL, NULL);
         if (!window_) {
             std::cerr << "Failed to create GLFW window\n";
@@ -694,6 +6224,11 @@ private:
             
 
 
+        if (headless_ && !setupOffscreenFramebuffer()) {
+            std::cerr << "Failed to create the offscreen framebuffer\n";
+            exit(EXIT_FAILURE);
+        }
+
         // Setup OpenGL state
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_PROGRAM_POINT_SIZE); // Enable program point size if set in shader
@@ -702,40 +6237,22 @@ private:
         shader_program_ = createShaderProgram(vertex_shader_src_, fragment_shader_src_);
         grid_shader_program_ = createShaderProgram(grid_vertex_shader_src_, grid_fragment_shader_src_);
         axes_shader_program_ = createShaderProgram(axes_vertex_shader_src_, axes_fragment_shader_src_);
+        raster_shader_program_ = createShaderProgram(raster_vertex_shader_src_, raster_fragment_shader_src_);
 
-        if (!shader_program_ || !grid_shader_program_ || !axes_shader_program_) {
+        if (!shader_program_ || !grid_shader_program_ || !axes_shader_program_ || !raster_shader_program_) {
             std::cerr << "Failed to create one or more shader programs\n";
             exit(EXIT_FAILURE);
         }
 
-        // Generate VBO and VAO for points
-        glGenVertexArrays(1, &vao_);
-        glGenBuffers(1, &vbo_);
-        glGenBuffers(1, &color_vbo_);
-
-        glBindVertexArray(vao_);
-
-        // Vertex positions
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // Vertex colors
-        glBindBuffer(GL_ARRAY_BUFFER, color_vbo_);
-        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-
         // Setup Grid
         setupGrid();
 
         // Setup Axes
         setupAxes();
 
+        // Setup the raster quad
+        setupRaster();
+
         // Check for OpenGL errors during initialization
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
@@ -815,6 +6332,7 @@ private:
         glBindVertexArray(grid_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, grid_vbo_);
         glBufferData(GL_ARRAY_BUFFER, grid_vertices.size() * sizeof(float), grid_vertices.data(), GL_STATIC_DRAW);
+        gpu_budget_.trackPinned(grid_vertices.size() * sizeof(float));
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
         glBindVertexArray(0);
@@ -835,88 +6353,842 @@ private:
             0.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f,
             0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,
 
-            // Z-axis (Blue)
-            0.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f,
-            0.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f,
-        };
+            // Z-axis (Blue)
+            0.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f,
+            0.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f,
+        };
+
+        glGenVertexArrays(1, &axes_vao_);
+        glGenBuffers(1, &axes_vbo_);
+
+        glBindVertexArray(axes_vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, axes_vbo_);
+        glBufferData(GL_ARRAY_BUFFER, axes_vertices.size() * sizeof(float), axes_vertices.data(), GL_STATIC_DRAW);
+        gpu_budget_.trackPinned(axes_vertices.size() * sizeof(float));
+        // Position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // Color attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        std::cout << "Axes setup complete.\n";
+    }
+
+    // Setup the unit quad the raster texture is drawn on (scaled to the grid in the shader)
+    void setupRaster() {
+        std::vector<float> corners = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            0.0f, 1.0f,
+            1.0f, 1.0f,
+        };
+
+        glGenVertexArrays(1, &raster_vao_);
+        glGenBuffers(1, &raster_vbo_);
+
+        glBindVertexArray(raster_vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, raster_vbo_);
+        glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(float), corners.data(), GL_STATIC_DRAW);
+        gpu_budget_.trackPinned(corners.size() * sizeof(float));
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    // Render function
+    void render() {
+        ++frame_index_;
+        if (headless_) {
+            glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo_);
+            glViewport(0, 0, width_, height_);
+        }
+        if (auto_rotate_ != 0.0f) azimuth_ += auto_rotate_ * frame_dt_;
+        {
+            std::lock_guard<std::mutex> lock(camera_mutex_);
+            if (pending_viewports_) {
+                viewports_ = std::move(*pending_viewports_);
+                active_viewport_ = 0;
+                if (!viewports_.empty()) applyCamera(viewports_[0].camera);
+            }
+            pending_viewports_.reset();
+            if (pending_camera_) applyCamera(*pending_camera_);
+            pending_camera_.reset();
+        }
+
+        // Switch to a newly opened tile file and frame its bounds
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            if (pending_tiles_) {
+                if (tiled_cloud_) tiled_cloud_->releaseGL();
+                tiled_cloud_ = std::move(pending_tiles_);
+                const TileFileHeader& h = tiled_cloud_->header();
+                for (int a = 0; a < 3; ++a)
+                    target_[a] = 0.5f * (h.bounds_min[a] + h.bounds_max[a]);
+            }
+            if (tiled_cloud_) tiled_cloud_->beginFrame(frame_index_);
+        }
+
+        // Clear buffers
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Dark background
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Bring the shared point data up to date once; every viewport then draws it
+        updateTimeline();
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            applyDataUpdates();
+            if (!raster_mode_ && raster_texture_) releaseRasterTexture();
+        }
+
+        if (viewports_.empty()) {
+            glViewport(0, 0, width_, height_);
+            drawScene(width_, height_);
+        } else {
+            viewports_[active_viewport_].camera = cameraState();
+            glEnable(GL_SCISSOR_TEST);
+            for (const Viewport& viewport : viewports_) {
+                int x = static_cast<int>(viewport.x * width_), y = static_cast<int>(viewport.y * height_);
+                int w = std::max(static_cast<int>(viewport.width * width_), 1);
+                int h = std::max(static_cast<int>(viewport.height * height_), 1);
+                glViewport(x, y, w, h);
+                glScissor(x, y, w, h);
+                applyCamera(viewport.camera);
+                drawScene(w, h);
+            }
+            glDisable(GL_SCISSOR_TEST);
+            glViewport(0, 0, width_, height_);
+            applyCamera(viewports_[active_viewport_].camera);
+        }
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            if (tiled_cloud_) tiled_cloud_->endFrame();
+        }
+
+        // Read the finished frame back asynchronously before it is presented
+        updateCapture();
+
+        // Swap buffers
+        glfwSwapBuffers(window_);
+
+        // Check for OpenGL errors
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            std::cerr << "OpenGL Error during rendering: " << getGLErrorString(error) << "\n";
+        }
+    }
+
+    // Draw grid, axes, points and overlays with the current camera into the current viewport
+    void drawScene(int width, int height) {
+        // Compute common view and projection matrices
+        Matrix4x4 projection = perspective(fov_, static_cast<float>(width) / height, 0.5f, Config::MAX_DISTANCE * 2.0f);
+        Matrix4x4 view = computeViewMatrix();
+
+        // Draw Grid with its own MVP
+        Matrix4x4 grid_model = Matrix4x4::identity();
+        grid_model = grid_model * rotate(grid_rotation_x_, 1.0f, 0.0f, 0.0f);
+        grid_model = grid_model * rotate(grid_rotation_y_, 0.0f, 1.0f, 0.0f);
+        grid_model = grid_model * rotate(grid_rotation_z_, 0.0f, 0.0f, 1.0f);
+        Matrix4x4 MVP_grid = projection * view * grid_model;
+
+        glUseProgram(grid_shader_program_);
+        glUniformMatrix4fv(glGetUniformLocation(grid_shader_program_, "MVP"), 1, GL_FALSE, MVP_grid.data.data());
+        glBindVertexArray(grid_vao_);
+        size_t num_lines = static_cast<size_t>((Config::GRID_SIZE / Config::GRID_STEP) * 2 + 1) * 2;
+        glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(num_lines * 2));
+        glBindVertexArray(0);
+
+        // Draw Axes
+        glUseProgram(axes_shader_program_);
+        glUniformMatrix4fv(glGetUniformLocation(axes_shader_program_, "MVP"), 1, GL_FALSE, (projection * view).data.data());
+        glBindVertexArray(axes_vao_);
+        glDrawArrays(GL_LINES, 0, 6);
+        glBindVertexArray(0);
+
+        // Draw Point Cloud, or its bird's-eye-view raster
+        glUseProgram(shader_program_);
+        glUniformMatrix4fv(glGetUniformLocation(shader_program_, "MVP"), 1, GL_FALSE, (projection * view).data.data());
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            setPointUniforms();
+            if (raster_mode_)
+                drawRaster(projection * view);
+            else
+                drawPointChunks(Frustum::fromMatrix(projection * view));
+            drawClusterBoxes(projection * view);
+        }
+        glUniform1i(glGetUniformLocation(shader_program_, "uTimeline"), 0);
+        glUniform1f(glGetUniformLocation(shader_program_, "uHiddenClass"), -1.0f);
+        glUniform1i(glGetUniformLocation(shader_program_, "uColorByScalar"), 0);
+
+        // Draw streamed tiles with the same shader and MVP
+        if (tiled_cloud_) {
+            float eye[3];
+            computeEyePosition(eye);
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            tiled_cloud_->draw(projection * view, eye, fov_, height);
+        }
+    }
+
+    // Apply recording requests and capture the finished frame (render thread)
+    void updateCapture() {
+        {
+            std::lock_guard<std::mutex> lock(capture_mutex_);
+            if (stop_capture_ || pending_capture_) recorder_.finish();
+            stop_capture_ = false;
+            if (pending_capture_) {
+                int width = width_, height = height_;
+                if (!headless_) glfwGetFramebufferSize(window_, &width, &height);
+                pending_capture_->lossless |= headless_; // Offscreen there is no frame rate to keep
+                if (recorder_.start(*pending_capture_, width, height))
+                    std::cout << "[Info] Recording " << width << "x" << height << " to " << pending_capture_->output << std::endl;
+                capture_ends_run_ = headless_ && pending_capture_->max_frames > 0;
+                pending_capture_.reset();
+            }
+        }
+        if (!recorder_.isRecording()) return;
+        recorder_.capture();
+        if (recorder_.isDone()) {
+            recorder_.finish();
+            if (capture_ends_run_) stop();
+        }
+    }
+
+    // Colour and depth renderbuffers the headless viewer draws into
+    bool setupOffscreenFramebuffer() {
+        glGenFramebuffers(1, &offscreen_fbo_);
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo_);
+        glGenRenderbuffers(1, &offscreen_color_);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color_);
+        glGenRenderbuffers(1, &offscreen_depth_);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width_, height_);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth_);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    // Advance event timeline playback
+    void updateTimeline() {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        TimelineState& t = timeline_;
+        if (t.enabled && t.speed != 0.0f) {
+            float step = t.speed * frame_dt_ * 1000.0f;
+            t.start += step;
+            t.end += step;
+            if (t.start > t.last) { // Loop the recording
+                t.end -= t.start - t.first;
+                t.start = t.first;
+            }
+        }
+    }
+
+    // Pass the time window and the hidden class to the point shader (data_mutex_ held)
+    void setPointUniforms() {
+        const TimelineState& t = timeline_;
+        glUniform1i(glGetUniformLocation(shader_program_, "uTimeline"), t.enabled ? 1 : 0);
+        glUniform1f(glGetUniformLocation(shader_program_, "uTimeStart"), t.start);
+        glUniform1f(glGetUniformLocation(shader_program_, "uTimeEnd"), t.end);
+        glUniform1f(glGetUniformLocation(shader_program_, "uDecay"), t.decay);
+        glUniform1f(glGetUniformLocation(shader_program_, "uHiddenClass"), hide_ground_ ? Config::GROUND_CLASS : -1.0f);
+        glUniform1i(glGetUniformLocation(shader_program_, "uClipBox"), clip_.box ? 1 : 0);
+        glUniform3fv(glGetUniformLocation(shader_program_, "uBoxCenter"), 1, clip_.center);
+        glUniformMatrix3fv(glGetUniformLocation(shader_program_, "uBoxAxes"), 1, GL_FALSE, &clip_.axes[0][0]);
+        glUniform3fv(glGetUniformLocation(shader_program_, "uBoxHalf"), 1, clip_.half_size);
+        glUniform1i(glGetUniformLocation(shader_program_, "uClipPlaneCount"), static_cast<GLint>(clip_.planes.size()));
+        if (!clip_.planes.empty())
+            glUniform4fv(glGetUniformLocation(shader_program_, "uClipPlanes"), static_cast<GLsizei>(clip_.planes.size()), clip_.planes[0].data());
+        glUniform1i(glGetUniformLocation(shader_program_, "uColorByScalar"), color_attribute_.empty() ? 0 : 1);
+        glUniform2f(glGetUniformLocation(shader_program_, "uScalarRange"), color_range_[0], color_range_[1]);
+    }
+
+    // Call fn(i, value) for the colour attribute of count slots from first (data_mutex_ held).
+    // Returns false if the stored points have no such channel.
+    template <typename Fn>
+    bool forEachScalar(size_t first, size_t count, Fn&& fn) const {
+        auto each = [&](auto&& value) {
+            for (size_t i = 0; i < count; ++i) fn(i, static_cast<double>(value(first + i)));
+            return true;
+        };
+        const std::string& name = color_attribute_;
+        if (name == "intensity" && !point_intensity_.empty()) return each([&](size_t s) { return point_intensity_[s]; });
+        if (name == "classification" && !point_classification_.empty()) return each([&](size_t s) { return point_classification_[s]; });
+        if (name == "cluster" && !point_cluster_.empty()) return each([&](size_t s) { return point_cluster_[s]; });
+        if (name == "time" && !point_time_.empty()) return each([&](size_t s) { return point_time_[s]; });
+        for (const AttributeChannel& channel : point_attributes_)
+            if (channel.name == name) return each([&](size_t s) { return channel.value(s); });
+        return false;
+    }
+
+    // Range of the colour attribute over the stored points; colouring falls back to the
+    // stored colours when the points lack the channel (data_mutex_ held)
+    void updateColorRange() {
+        if (color_attribute_.empty()) return;
+        scalar_offset_ = 0.0;
+        color_range_[0] = INFINITY;
+        color_range_[1] = -INFINITY;
+        if (!forEachScalar(0, 0, [](size_t, double) {})) {
+            color_attribute_.clear();
+            return;
+        }
+        std::mutex range_mutex;
+        double low = INFINITY, high = -INFINITY;
+        for (const auto& range : liveRanges()) {
+            parallelForChunks(range.second - range.first, Config::DECODE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+                double chunk_low = INFINITY, chunk_high = -INFINITY;
+                forEachScalar(range.first + begin, end - begin, [&](size_t, double v) {
+                    chunk_low = std::min(chunk_low, v);
+                    chunk_high = std::max(chunk_high, v);
+                });
+                std::lock_guard<std::mutex> lock(range_mutex);
+                low = std::min(low, chunk_low);
+                high = std::max(high, chunk_high);
+            });
+        }
+        if (low > high) return; // No points yet: the range grows as they arrive
+        scalar_offset_ = low;
+        color_range_[0] = 0.0f;
+        color_range_[1] = static_cast<float>(high - low);
+    }
+
+    // Widen the colour range by newly written slots
+    void growColorRange(size_t first, size_t count) {
+        if (std::isinf(color_range_[0]) && count > 0) forEachScalar(first, 1, [&](size_t, double v) { scalar_offset_ = v; });
+        forEachScalar(first, count, [&](size_t, double v) {
+            float relative = static_cast<float>(v - scalar_offset_);
+            color_range_[0] = std::min(color_range_[0], relative);
+            color_range_[1] = std::max(color_range_[1], relative);
+        });
+    }
+
+    // Upload the colour attribute of the chunk-relative slots [first, last)
+    void uploadScalars(PointChunk& chunk, size_t first, size_t last) {
+        scalar_staging_.resize(last - first);
+        if (!forEachScalar(chunk.first + first, last - first, [&](size_t i, double v) {
+                scalar_staging_[i] = static_cast<float>(v - scalar_offset_); }))
+            std::fill(scalar_staging_.begin(), scalar_staging_.end(), 0.0f);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.scalar_vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(float), (last - first) * sizeof(float), scalar_staging_.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Re-split point_cloud_ into chunks after a data update; all chunks become stale
+    void rebuildChunks() {
+        size_t point_count = point_cloud_.size() / 3;
+        size_t chunk_count = (point_count + Config::GPU_CHUNK_POINTS - 1) / Config::GPU_CHUNK_POINTS;
+        while (chunks_.size() > chunk_count) {
+            releaseChunk(*chunks_.back());
+            chunks_.pop_back();
+        }
+        while (chunks_.size() < chunk_count)
+            chunks_.push_back(std::make_unique<PointChunk>());
+
+        std::vector<size_t> indices(chunk_count);
+        std::iota(indices.begin(), indices.end(), size_t{0});
+        std::for_each(std::execution::par, indices.begin(), indices.end(),
+            [&](size_t c) {
+                PointChunk& chunk = *chunks_[c];
+                chunk.first = c * Config::GPU_CHUNK_POINTS;
+                chunk.count = std::min(Config::GPU_CHUNK_POINTS, point_count - chunk.first);
+                chunk.stale = true;
+                chunk.dirty_first = chunk.dirty_last = 0;
+                recomputeChunkBounds(chunk);
+            }
+        );
+        dirty_ranges_.clear();
+    }
+
+    // Bounds of exactly the points a chunk holds now
+    void recomputeChunkBounds(PointChunk& chunk) const {
+        for (int a = 0; a < 3; ++a) {
+            chunk.bounds_min[a] = INFINITY;
+            chunk.bounds_max[a] = -INFINITY;
+        }
+        chunk.time_min = INFINITY;
+        chunk.time_max = -INFINITY;
+        growChunkBounds(chunk, chunk.first, chunk.first + chunk.count);
+        chunk.rewritten = 0;
+    }
+
+    void growChunkBounds(PointChunk& chunk, size_t first, size_t last) const {
+        const float* p = point_cloud_.data();
+        for (size_t i = first; i < last; ++i) {
+            for (int a = 0; a < 3; ++a) {
+                chunk.bounds_min[a] = std::min(chunk.bounds_min[a], p[i * 3 + a]);
+                chunk.bounds_max[a] = std::max(chunk.bounds_max[a], p[i * 3 + a]);
+            }
+        }
+        for (size_t i = first; i < last && !point_time_.empty(); ++i) {
+            chunk.time_min = std::min(chunk.time_min, point_time_[i]);
+            chunk.time_max = std::max(chunk.time_max, point_time_[i]);
+        }
+    }
+
+    // Apply the slots written since the last frame: extend the chunk bounds and mark the
+    // spans to re-upload, so the per-frame cost follows the batch size, not the cloud size.
+    // Once the ring has written a chunk's worth of slots into a chunk, its old points are gone
+    // and the grown bounds are recomputed from the slots, so culling stays tight as the
+    // ring wraps (amortized one extra read per written point).
+    void updateChunks() {
+        size_t point_count = slotCount();
+        size_t chunk_count = (point_count + Config::GPU_CHUNK_POINTS - 1) / Config::GPU_CHUNK_POINTS;
+        if (chunk_count < chunks_.size()) {
+            rebuildChunks();
+            return;
+        }
+        while (chunks_.size() < chunk_count) {
+            auto chunk = std::make_unique<PointChunk>();
+            chunk->first = chunks_.size() * Config::GPU_CHUNK_POINTS;
+            recomputeChunkBounds(*chunk); // Empty: inverted bounds
+            chunks_.push_back(std::move(chunk));
+        }
+        for (const auto& range : dirty_ranges_) {
+            for (size_t c = range.first / Config::GPU_CHUNK_POINTS;
+                 c < chunk_count && c * Config::GPU_CHUNK_POINTS < range.second; ++c) {
+                PointChunk& chunk = *chunks_[c];
+                size_t first = std::max(range.first, chunk.first);
+                size_t last = std::min(range.second, chunk.first + Config::GPU_CHUNK_POINTS);
+                chunk.count = std::min(Config::GPU_CHUNK_POINTS, point_count - chunk.first);
+                chunk.rewritten += last - first;
+                if (chunk.rewritten >= Config::GPU_CHUNK_POINTS)
+                    recomputeChunkBounds(chunk);
+                else
+                    growChunkBounds(chunk, first, last);
+                if (chunk.dirty_first == chunk.dirty_last) {
+                    chunk.dirty_first = first - chunk.first;
+                    chunk.dirty_last = last - chunk.first;
+                } else {
+                    chunk.dirty_first = std::min(chunk.dirty_first, first - chunk.first);
+                    chunk.dirty_last = std::max(chunk.dirty_last, last - chunk.first);
+                }
+            }
+        }
+        dirty_ranges_.clear();
+    }
+
+    // Bring a chunk's GPU buffers up to date: only its dirty span is sent with
+    // glBufferSubData while it fits, otherwise the buffers are (re)allocated with room
+    // to grow geometrically, evicting other chunks if needed
+    bool uploadChunk(PointChunk& chunk) {
+        bool with_time = !point_time_.empty();
+        bool with_class = !point_classification_.empty();
+        bool with_scalar = !color_attribute_.empty();
+        if (chunk.vao && chunk.count <= chunk.gpu_capacity && with_time == (chunk.time_vbo != 0) &&
+            with_class == (chunk.class_vbo != 0) && with_scalar == (chunk.scalar_vbo != 0)) {
+            if (chunk.stale) {
+                chunk.dirty_first = 0;
+                chunk.dirty_last = chunk.count;
+                chunk.stale = false;
+            }
+            if (chunk.scalar_stale && chunk.scalar_vbo) {
+                // Another colour attribute: send only that channel
+                uploadScalars(chunk, 0, chunk.count);
+                chunk.scalar_stale = false;
+            }
+            if (chunk.dirty_first < chunk.dirty_last) {
+                size_t offset = chunk.dirty_first * 3 * sizeof(float);
+                size_t size = (chunk.dirty_last - chunk.dirty_first) * 3 * sizeof(float);
+                const size_t first = (chunk.first + chunk.dirty_first) * 3;
+                glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, point_cloud_.data() + first);
+                glBindBuffer(GL_ARRAY_BUFFER, chunk.color_vbo);
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, point_colors_.data() + first);
+                if (chunk.time_vbo) {
+                    glBindBuffer(GL_ARRAY_BUFFER, chunk.time_vbo);
+                    glBufferSubData(GL_ARRAY_BUFFER, offset / 3, size / 3, point_time_.data() + first / 3);
+                }
+                if (chunk.class_vbo) {
+                    glBindBuffer(GL_ARRAY_BUFFER, chunk.class_vbo);
+                    glBufferSubData(GL_ARRAY_BUFFER, offset / (3 * sizeof(float)), size / (3 * sizeof(float)),
+                                    point_classification_.data() + first / 3);
+                }
+                if (chunk.scalar_vbo) uploadScalars(chunk, chunk.dirty_first, chunk.dirty_last);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                chunk.dirty_first = chunk.dirty_last = 0;
+            }
+            return true;
+        }
 
-        glGenVertexArrays(1, &axes_vao_);
-        glGenBuffers(1, &axes_vbo_);
+        size_t capacity = std::min(Config::GPU_CHUNK_POINTS, std::max<size_t>(chunk.count, 4096));
+        if (chunk.gpu_capacity && chunk.count > chunk.gpu_capacity)
+            capacity = std::min(Config::GPU_CHUNK_POINTS, std::max(chunk.count, chunk.gpu_capacity * 2));
+        size_t bytes = capacity * (6 + with_time + with_scalar) * sizeof(float) + (with_class ? capacity : 0);
+        releaseChunk(chunk);
+        if (!gpu_budget_.reserve(bytes, frame_index_))
+            return false;
 
-        glBindVertexArray(axes_vao_);
-        glBindBuffer(GL_ARRAY_BUFFER, axes_vbo_);
-        glBufferData(GL_ARRAY_BUFFER, axes_vertices.size() * sizeof(float), axes_vertices.data(), GL_STATIC_DRAW);
-        // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        // Drain errors raised elsewhere so the out-of-memory check below only sees this upload
+        while (glGetError() != GL_NO_ERROR) {}
+        glGenVertexArrays(1, &chunk.vao);
+        glGenBuffers(1, &chunk.vbo);
+        glGenBuffers(1, &chunk.color_vbo);
+        glBindVertexArray(chunk.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, chunk.count * 3 * sizeof(float), point_cloud_.data() + chunk.first * 3);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
-        // Color attribute
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.color_vbo);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, chunk.count * 3 * sizeof(float), point_colors_.data() + chunk.first * 3);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
+        if (with_time) {
+            glGenBuffers(1, &chunk.time_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.time_vbo);
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, chunk.count * sizeof(float), point_time_.data() + chunk.first);
+            glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+            glEnableVertexAttribArray(2);
+        }
+        if (with_class) {
+            glGenBuffers(1, &chunk.class_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.class_vbo);
+            glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, chunk.count, point_classification_.data() + chunk.first);
+            glVertexAttribPointer(3, 1, GL_UNSIGNED_BYTE, GL_FALSE, 1, (void*)0);
+            glEnableVertexAttribArray(3);
+        }
+        if (with_scalar) {
+            glGenBuffers(1, &chunk.scalar_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.scalar_vbo);
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+            glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+            glEnableVertexAttribArray(4);
+            uploadScalars(chunk, 0, chunk.count);
+            chunk.scalar_stale = false;
+        }
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        std::cout << "Axes setup complete.\n";
+        // The driver may still refuse: give the memory back and stop growing the resident set
+        if (glGetError() == GL_OUT_OF_MEMORY) {
+            deleteChunkBuffers(chunk);
+            gpu_budget_.reportOutOfMemory();
+            std::cerr << "Warning: GL_OUT_OF_MEMORY, GPU budget lowered to "
+                      << gpu_budget_.stats().budget_bytes << " bytes\n";
+            return false;
+        }
+        chunk.gpu = gpu_budget_.trackEvictable(bytes, [this, &chunk]() { deleteChunkBuffers(chunk); }, frame_index_);
+        chunk.gpu_capacity = capacity;
+        chunk.dirty_first = chunk.dirty_last = 0;
+        chunk.stale = false;
+        return true;
     }
 
-    // Render function
-    void render() {
-        // Update buffer if data has been updated
+    static void deleteChunkBuffers(PointChunk& chunk) {
+        if (chunk.vbo) glDeleteBuffers(1, &chunk.vbo);
+        if (chunk.color_vbo) glDeleteBuffers(1, &chunk.color_vbo);
+        if (chunk.time_vbo) glDeleteBuffers(1, &chunk.time_vbo);
+        if (chunk.class_vbo) glDeleteBuffers(1, &chunk.class_vbo);
+        if (chunk.scalar_vbo) glDeleteBuffers(1, &chunk.scalar_vbo);
+        if (chunk.vao) glDeleteVertexArrays(1, &chunk.vao);
+        chunk.vbo = chunk.color_vbo = chunk.time_vbo = chunk.class_vbo = chunk.scalar_vbo = chunk.vao = 0;
+        chunk.gpu = 0;
+        chunk.gpu_capacity = 0;
+    }
+
+    void releaseChunk(PointChunk& chunk) {
+        if (!chunk.vao) return;
+        gpu_budget_.release(chunk.gpu);
+        deleteChunkBuffers(chunk);
+    }
+
+    // Expire old points and bring the chunk bounds and the raster up to date (data_mutex_ held)
+    void applyDataUpdates() {
+        if (expirePoints(std::chrono::steady_clock::now())) data_updated_ = true;
         if (data_updated_) {
-            std::lock_guard<std::mutex> lock(data_mutex_);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-            glBufferData(GL_ARRAY_BUFFER, point_cloud_.size() * sizeof(float), point_cloud_.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ARRAY_BUFFER, color_vbo_);
-            glBufferData(GL_ARRAY_BUFFER, point_colors_.size() * sizeof(float), point_colors_.data(), GL_DYNAMIC_DRAW);
+            if (layout_changed_) rebuildChunks();
+            else updateChunks();
+            layout_changed_ = false;
             data_updated_ = false;
         }
+        if (raster_job_ && raster_job_->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            finishRasterRebuild();
+        if (raster_mode_ && raster_.needsRebuild() && !raster_job_) {
+            if (raster_discards_ >= Config::BEV_REBUILD_RETRIES) {
+                // Points keep moving under the worker (decimation): bin them in place once
+                std::vector<std::pair<size_t, size_t>> ranges;
+                for (const auto& range : liveRanges())
+                    if (range.first < range.second) ranges.push_back(range);
+                raster_.rebuild(point_cloud_.data(), point_intensity_.empty() ? nullptr : point_intensity_.data(),
+                                ranges, raster_options_.cell_size);
+                raster_discards_ = 0;
+            } else {
+                startRasterRebuild();
+            }
+        }
+    }
 
-        // Clear buffers
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Dark background
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Copy the stored positions (and intensity) in age order and bin them into a new grid on a
+    // worker. Only the copy holds data_mutex_; the previous grid stays on screen meanwhile.
+    void startRasterRebuild() {
+        auto positions = std::make_shared<std::vector<float>>(ring_count_ * 3);
+        auto intensity = std::make_shared<std::vector<float>>(point_intensity_.empty() ? 0 : ring_count_);
+        size_t offset = 0;
+        for (const auto& range : liveRanges()) {
+            size_t n = range.second - range.first;
+            std::copy_n(point_cloud_.begin() + range.first * 3, n * 3, positions->begin() + offset * 3);
+            if (!intensity->empty())
+                std::copy_n(point_intensity_.begin() + range.first, n, intensity->begin() + offset);
+            offset += n;
+        }
+        raster_job_ = std::make_unique<RasterJob>();
+        raster_job_->positions = positions;
+        raster_job_->intensity = intensity;
+        float cell_size = raster_options_.cell_size;
+        raster_job_->result = std::async(std::launch::async, [positions, intensity, cell_size]() {
+            DensityRaster raster;
+            raster.rebuild(positions->data(), intensity->empty() ? nullptr : intensity->data(),
+                           { { 0, positions->size() / 3 } }, cell_size);
+            return raster;
+        });
+    }
 
-        // Compute common view and projection matrices
-        Matrix4x4 projection = perspective(fov_, static_cast<float>(width_) / height_, 0.5f, Config::MAX_DISTANCE * 2.0f);
-        Matrix4x4 view = computeViewMatrix();
+    // Swap in a finished background rebuild: drop the copied points that have left the ring
+    // since (the oldest ones) and bin the ones stored since (the newest slots)
+    void finishRasterRebuild() {
+        std::unique_ptr<RasterJob> job = std::move(raster_job_);
+        DensityRaster raster = job->result.get();
+        if (job->stale || !raster_mode_) {
+            if (raster_mode_) ++raster_discards_;
+            return; // raster_ still needs a rebuild; the next frame starts one
+        }
+        raster_discards_ = 0;
+        const float* intensity = job->intensity->empty() ? nullptr : job->intensity->data();
+        size_t copied = job->positions->size() / 3;
+        bool ok = raster.accumulate(job->positions->data(), intensity, 0, std::min(job->removed, copied), -1);
+        size_t added = std::min(job->added, ring_count_);
+        size_t slots = slotCount();
+        for (size_t i = ring_count_ - added; ok && i < ring_count_; ) {
+            size_t first = (ring_tail_ + i) % slots;
+            size_t run = std::min(ring_count_ - i, slots - first);
+            ok = raster.accumulate(point_cloud_.data(), point_intensity_.empty() ? nullptr : point_intensity_.data(),
+                                   first, first + run, 1);
+            i += run;
+        }
+        raster_ = std::move(raster);
+        if (!ok || raster_.removedSinceRebuild() > ring_count_) raster_.invalidate();
+    }
 
-        // Draw Grid with its own MVP
-        Matrix4x4 grid_model = Matrix4x4::identity();
-        grid_model = grid_model * rotate(grid_rotation_x_, 1.0f, 0.0f, 0.0f);
-        grid_model = grid_model * rotate(grid_rotation_y_, 0.0f, 1.0f, 0.0f);
-        grid_model = grid_model * rotate(grid_rotation_z_, 0.0f, 0.0f, 1.0f);
-        Matrix4x4 MVP_grid = projection * view * grid_model;
+    // The binned points no longer match the slots: rebuild the raster (and drop a running rebuild)
+    void invalidateRaster() {
+        raster_.invalidate();
+        if (raster_job_) raster_job_->stale = true;
+    }
 
-        glUseProgram(grid_shader_program_);
-        glUniformMatrix4fv(glGetUniformLocation(grid_shader_program_, "MVP"), 1, GL_FALSE, MVP_grid.data.data());
-        glBindVertexArray(grid_vao_);
-        size_t num_lines = static_cast<size_t>((Config::GRID_SIZE / Config::GRID_STEP) * 2 + 1) * 2;
-        glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(num_lines * 2));
-        glBindVertexArray(0);
+    // Slots holding displayed points: one range, or two once the ring wraps
+    std::array<std::pair<size_t, size_t>, 2> liveRanges() const {
+        size_t slots = slotCount();
+        std::array<std::pair<size_t, size_t>, 2> live = {{ { ring_tail_, std::min(ring_tail_ + ring_count_, slots) }, { 0, 0 } }};
+        if (ring_tail_ + ring_count_ > slots) live[1].second = ring_tail_ + ring_count_ - slots;
+        return live;
+    }
 
-        // Draw Axes
-        glUseProgram(axes_shader_program_);
-        glUniformMatrix4fv(glGetUniformLocation(axes_shader_program_, "MVP"), 1, GL_FALSE, (projection * view).data.data());
-        glBindVertexArray(axes_vao_);
-        glDrawArrays(GL_LINES, 0, 6);
+    // Draw the visible chunks, (re-)uploading those that were evicted or are stale (data_mutex_ held)
+    void drawPointChunks(const Frustum& frustum) {
+        auto live = liveRanges();
+        for (auto& ptr : chunks_) {
+            PointChunk& chunk = *ptr;
+            if (!frustum.intersectsBox(chunk.bounds_min, chunk.bounds_max)) continue;
+            if (clip_.active() && clip_.classify(chunk.bounds_min, chunk.bounds_max) == ClipOverlap::Outside)
+                continue; // Nothing of the chunk survives the clip test
+            if (timeline_.enabled && (chunk.time_max < timeline_.start || chunk.time_min > timeline_.end))
+                continue; // Events sorted by time cull whole chunks outside the window
+            bool bound = false;
+            for (const auto& range : live) {
+                size_t first = std::max(range.first, chunk.first);
+                size_t last = std::min(range.second, chunk.first + chunk.count);
+                if (first >= last) continue;
+                if (!bound) {
+                    if (!uploadChunk(chunk)) break;
+                    gpu_budget_.touch(chunk.gpu, frame_index_);
+                    glBindVertexArray(chunk.vao);
+                    bound = true;
+                }
+                glDrawArrays(GL_POINTS, static_cast<GLint>(first - chunk.first), static_cast<GLsizei>(last - first));
+            }
+        }
         glBindVertexArray(0);
+    }
 
-        // Draw Point Cloud
-        glUseProgram(shader_program_);
-        glUniformMatrix4fv(glGetUniformLocation(shader_program_, "MVP"), 1, GL_FALSE, (projection * view).data.data());
-        glBindVertexArray(vao_);
-        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(point_cloud_.size() / 3));
+    // Draw the raster as a textured quad, uploading only the cells changed since the last frame
+    void drawRaster(const Matrix4x4& mvp) {
+        if (raster_.empty()) return;
+        int width = raster_.width(), height = raster_.height();
+        if (raster_texture_size_[0] != width || raster_texture_size_[1] != height) {
+            releaseRasterTexture();
+            glGenTextures(1, &raster_texture_);
+            glBindTexture(GL_TEXTURE_2D, raster_texture_);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            raster_gpu_ = gpu_budget_.trackPinned(static_cast<size_t>(width) * height * 3 * sizeof(float));
+            raster_texture_size_[0] = width;
+            raster_texture_size_[1] = height;
+        }
+        glBindTexture(GL_TEXTURE_2D, raster_texture_);
+        int rect[4];
+        if (raster_.takeDirty(rect)) {
+            raster_.texels(rect, raster_texels_);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect[0], rect[1], rect[2] - rect[0], rect[3] - rect[1],
+                            GL_RGB, GL_FLOAT, raster_texels_.data());
+        }
+
+        float range[2] = { 0.0f, std::log(1.0f + static_cast<float>(raster_.maxCount())) };
+        if (raster_options_.channel == RasterChannel::MaxZ) {
+            range[0] = raster_.zMin();
+            range[1] = raster_.zMax();
+        } else if (raster_options_.channel == RasterChannel::Intensity) {
+            range[0] = raster_.intensityMin();
+            range[1] = raster_.intensityMax();
+        }
+        if (!std::isfinite(range[0]) || !std::isfinite(range[1])) {
+            range[0] = 0.0f;
+            range[1] = 1.0f;
+        }
+        const float* origin = raster_.origin();
+        float extent[2] = { width * raster_.cellSize(), height * raster_.cellSize() };
+
+        glUseProgram(raster_shader_program_);
+        glUniformMatrix4fv(glGetUniformLocation(raster_shader_program_, "MVP"), 1, GL_FALSE, mvp.data.data());
+        glUniform2f(glGetUniformLocation(raster_shader_program_, "uOrigin"), origin[0], origin[1]);
+        glUniform2f(glGetUniformLocation(raster_shader_program_, "uExtent"), extent[0], extent[1]);
+        glUniform1f(glGetUniformLocation(raster_shader_program_, "uHeight"), std::isfinite(raster_.zMin()) ? raster_.zMin() : 0.0f);
+        glUniform1i(glGetUniformLocation(raster_shader_program_, "uChannel"), static_cast<int>(raster_options_.channel));
+        glUniform2f(glGetUniformLocation(raster_shader_program_, "uRange"), range[0], range[1]);
+        glUniform1i(glGetUniformLocation(raster_shader_program_, "uRaster"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(raster_vao_);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(shader_program_); // Streamed tiles are drawn with the point shader next
+    }
 
-        // Swap buffers
-        glfwSwapBuffers(window_);
+    void releaseRasterTexture() {
+        if (!raster_texture_) return;
+        glDeleteTextures(1, &raster_texture_);
+        gpu_budget_.release(raster_gpu_);
+        raster_texture_ = 0;
+        raster_texture_size_[0] = raster_texture_size_[1] = 0;
+    }
 
-        // Check for OpenGL errors
-        GLenum error = glGetError();
-        if (error != GL_NO_ERROR) {
-            std::cerr << "OpenGL Error during rendering: " << getGLErrorString(error) << "\n";
+    // Draw the cluster bounding boxes as lines, rebuilding their vertices when the clusters changed
+    void drawClusterBoxes(const Matrix4x4& mvp) {
+        if (cluster_boxes_dirty_) {
+            std::vector<float> vertices;
+            vertices.reserve((cluster_boxes_.size() + 1) * 24 * 6);
+            // 12 edges: each pair of corners differing in exactly one axis; corner(c, xyz)
+            auto addBox = [&](auto&& corner, const float color[3]) {
+                for (int a = 0; a < 3; ++a) {
+                    for (int c = 0; c < 8; ++c) {
+                        if (c & (1 << a)) continue;
+                        for (int end = 0; end < 2; ++end) {
+                            float p[3];
+                            corner(c | (end << a), p);
+                            vertices.insert(vertices.end(), p, p + 3);
+                            vertices.insert(vertices.end(), color, color + 3);
+                        }
+                    }
+                }
+            };
+            for (const ClusterBox& box : cluster_boxes_) {
+                if (box.count == 0) continue;
+                float color[3];
+                clusterColor(box.id, color);
+                addBox([&](int c, float p[3]) {
+                    for (int a = 0; a < 3; ++a) p[a] = c & (1 << a) ? box.max[a] : box.min[a];
+                }, color);
+            }
+            if (clip_.box) {
+                const float white[3] = { 1.0f, 1.0f, 1.0f };
+                addBox([&](int c, float p[3]) {
+                    std::copy_n(clip_.center, 3, p);
+                    for (int a = 0; a < 3; ++a) {
+                        float h = c & (1 << a) ? clip_.half_size[a] : -clip_.half_size[a];
+                        for (int k = 0; k < 3; ++k) p[k] += h * clip_.axes[a][k];
+                    }
+                }, white);
+            }
+            if (!cluster_vao_) {
+                glGenVertexArrays(1, &cluster_vao_);
+                glGenBuffers(1, &cluster_vbo_);
+                glBindVertexArray(cluster_vao_);
+                glBindBuffer(GL_ARRAY_BUFFER, cluster_vbo_);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+                glEnableVertexAttribArray(1);
+                glBindVertexArray(0);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, cluster_vbo_);
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            gpu_budget_.release(cluster_gpu_);
+            cluster_gpu_ = gpu_budget_.trackPinned(vertices.size() * sizeof(float));
+            cluster_vertices_ = static_cast<GLsizei>(vertices.size() / 6);
+            cluster_boxes_dirty_ = false;
         }
+        if (cluster_vertices_ == 0) return;
+
+        glUseProgram(axes_shader_program_);
+        glUniformMatrix4fv(glGetUniformLocation(axes_shader_program_, "MVP"), 1, GL_FALSE, mvp.data.data());
+        glBindVertexArray(cluster_vao_);
+        glDrawArrays(GL_LINES, 0, cluster_vertices_);
+        glBindVertexArray(0);
+        glUseProgram(shader_program_);
+    }
+
+    CameraState cameraState() const {
+        CameraState camera;
+        std::copy_n(target_, 3, camera.target);
+        camera.distance = distance_;
+        camera.azimuth = azimuth_;
+        camera.elevation = elevation_;
+        camera.pan_x = pan_x_;
+        camera.pan_y = pan_y_;
+        camera.fov = fov_;
+        return camera;
+    }
+
+    void applyCamera(const CameraState& camera) {
+        std::copy_n(camera.target, 3, target_);
+        distance_ = camera.distance;
+        azimuth_ = camera.azimuth;
+        elevation_ = camera.elevation;
+        pan_x_ = camera.pan_x;
+        pan_y_ = camera.pan_y;
+        fov_ = camera.fov;
+    }
+
+    // Record the camera if it moved since the last recorded state
+    void traceCamera() {
+        CameraState camera = cameraState();
+        if (camera_traced_ && std::memcmp(&camera, &traced_camera_, sizeof(camera)) == 0) return;
+        trace_.recordCamera(camera);
+        traced_camera_ = camera;
+        camera_traced_ = true;
     }
 
     // Compute the View Matrix based on Arcball Camera parameters
     Matrix4x4 computeViewMatrix() {
+        float eye[3];
+        computeEyePosition(eye);
+        float center[3] = { target_[0] + pan_x_, target_[1] + pan_y_, target_[2] };
+        float up[3] = { 0.0f, 0.0f, 1.0f }; // Set Z-up
+
+        return lookAt(eye, center, up);
+    }
+
+    // Camera position in world space from the Arcball Camera parameters
+    void computeEyePosition(float eye[3]) const {
         // Convert spherical coordinates to Cartesian coordinates
         float rad_azimuth = azimuth_ * M_PI / 180.0f;
         float rad_elevation = elevation_ * M_PI / 180.0f;
@@ -925,11 +7197,9 @@ private:
         float cam_y = target_[1] + distance_ * cosf(rad_elevation) * sinf(rad_azimuth);
         float cam_z = target_[2] + distance_ * sinf(rad_elevation); // Updated to set Z based on elevation
 
-        float eye[3] = { cam_x + pan_x_, cam_y + pan_y_, cam_z };
-        float center[3] = { target_[0] + pan_x_, target_[1] + pan_y_, target_[2] };
-        float up[3] = { 0.0f, 0.0f, 1.0f }; // Set Z-up
-
-        return lookAt(eye, center, up);
+        eye[0] = cam_x + pan_x_;
+        eye[1] = cam_y + pan_y_;
+        eye[2] = cam_z;
     }
 
     // Perspective projection matrix
@@ -1035,11 +7305,35 @@ private:
         return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
     }
 
+    // Hand the camera controls to the viewport under the cursor; a drag keeps its viewport
+    void selectViewport(GLFWwindow* window) {
+        if (viewports_.size() < 2 || cursor_captured_ || middle_button_pressed_ || right_button_pressed_) return;
+        double cursor_x, cursor_y;
+        int window_width, window_height;
+        glfwGetCursorPos(window, &cursor_x, &cursor_y);
+        glfwGetWindowSize(window, &window_width, &window_height);
+        if (window_width <= 0 || window_height <= 0) return;
+        float x = static_cast<float>(cursor_x / window_width);
+        float y = 1.0f - static_cast<float>(cursor_y / window_height);
+        for (size_t i = 0; i < viewports_.size(); ++i) {
+            const Viewport& v = viewports_[i];
+            if (x < v.x || x >= v.x + v.width || y < v.y || y >= v.y + v.height) continue;
+            if (i != active_viewport_) {
+                viewports_[active_viewport_].camera = cameraState();
+                active_viewport_ = i;
+                applyCamera(viewports_[i].camera);
+            }
+            return;
+        }
+    }
+
     // Process input
     void processInput(GLFWwindow* window) {
-        float dt = delta_time();
+        float dt = headless_ ? 1.0f / Config::CAPTURE_FPS : delta_time(); // Fixed step for captured video
+        frame_dt_ = dt;
         float pan_speed = Config::PAN_SPEED * dt;
         float rotation_speed = 50.0f * dt; // degrees per second
+        selectViewport(window);
 
         // Camera panning
         if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
@@ -1077,6 +7371,186 @@ private:
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window_, true);
 
+        // Event timeline: Space plays/pauses, [ and ] scrub, - and = resize the window
+        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+            if (!play_pressed_) {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                if (timeline_.speed != 0.0f) {
+                    paused_speed_ = timeline_.speed;
+                    timeline_.speed = 0.0f;
+                } else {
+                    timeline_.speed = paused_speed_;
+                }
+                play_pressed_ = true;
+            }
+        } else {
+            play_pressed_ = false;
+        }
+        bool scrub_back = glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+        bool scrub_forward = glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+        bool shrink = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS;
+        bool grow = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS;
+        if (scrub_back || scrub_forward || shrink || grow) {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            float length = timeline_.end - timeline_.start;
+            float scrub = std::max(length, 1.0f) * 2.0f * dt; // Two windows per second
+            if (scrub_back) { timeline_.start -= scrub; timeline_.end -= scrub; }
+            if (scrub_forward) { timeline_.start += scrub; timeline_.end += scrub; }
+            if (shrink) timeline_.start = std::min(timeline_.end, timeline_.start + length * dt);
+            if (grow) timeline_.start -= std::max(length, 1.0f) * dt;
+        }
+
+        // Capture: P saves a screenshot, F9 starts/stops recording a PNG sequence
+        if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+            if (!screenshot_pressed_) {
+                char name[64];
+                std::snprintf(name, sizeof(name), "screenshot_%llu.png", static_cast<unsigned long long>(frame_index_));
+                saveScreenshot(name);
+                screenshot_pressed_ = true;
+            }
+        } else {
+            screenshot_pressed_ = false;
+        }
+        // Clip box: O shows it around the view centre, aligned with the view, or hides it;
+        // J / L turn it, K / I shrink or grow it, Y replaces the cloud by the points inside
+        if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) {
+            if (!clip_pressed_) {
+                ClipRegion region = clipRegion();
+                region.box = !region.box;
+                if (region.box) {
+                    clip_yaw_ = azimuth_;
+                    region.setYaw(clip_yaw_);
+                    float center[3] = { target_[0] + pan_x_, target_[1] + pan_y_, target_[2] };
+                    std::copy_n(center, 3, region.center);
+                }
+                setClipRegion(region);
+                clip_pressed_ = true;
+            }
+        } else {
+            clip_pressed_ = false;
+        }
+        bool turn_left = glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS;
+        bool turn_right = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+        bool shrink_box = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+        bool grow_box = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+        if (turn_left || turn_right || shrink_box || grow_box) {
+            ClipRegion region = clipRegion();
+            if (region.box) {
+                if (turn_left) clip_yaw_ += rotation_speed;
+                if (turn_right) clip_yaw_ -= rotation_speed;
+                region.setYaw(clip_yaw_);
+                float scale = shrink_box ? 1.0f - dt : (grow_box ? 1.0f + dt : 1.0f);
+                for (float& h : region.half_size) h = std::max(h * scale, 0.01f);
+                setClipRegion(region);
+            }
+        }
+        if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS) {
+            if (!extract_pressed_) {
+                extractRegionAsync();
+                extract_pressed_ = true;
+            }
+        } else {
+            extract_pressed_ = false;
+        }
+
+        // F5 exports the stored points to export_<frame>.pcd in the background
+        if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS) {
+            if (!export_pressed_) {
+                char name[64];
+                std::snprintf(name, sizeof(name), "export_%llu.pcd", static_cast<unsigned long long>(frame_index_));
+                exportAsync(name, PointFileFormat::PcdBinary);
+                export_pressed_ = true;
+            }
+        } else {
+            export_pressed_ = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS) {
+            if (!record_pressed_) {
+                if (recorder_.isRecording()) {
+                    stopRecording();
+                } else {
+                    CaptureOptions options;
+                    options.output = "capture";
+                    startRecording(options);
+                }
+                record_pressed_ = true;
+            }
+        } else {
+            record_pressed_ = false;
+        }
+
+        // G hides or shows the points labelled as ground
+        if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) {
+            if (!ground_pressed_) {
+                hide_ground_ = !hide_ground_;
+                ground_pressed_ = true;
+            }
+        } else {
+            ground_pressed_ = false;
+        }
+
+        // N colours the points by the next stored attribute, and after the last by their colours
+        if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS) {
+            if (!color_pressed_) {
+                auto names = colorAttributes();
+                names.insert(names.begin(), "");
+                auto current = std::find(names.begin(), names.end(), colorAttribute());
+                size_t next = current == names.end() ? 0 : (current - names.begin() + 1) % names.size();
+                if (setColorAttribute(names[next]))
+                    std::cout << "[Info] Colouring by " << (names[next].empty() ? "point colour" : names[next]) << std::endl;
+                color_pressed_ = true;
+            }
+        } else {
+            color_pressed_ = false;
+        }
+
+        // F2 splits the window into perspective, top and side views or joins them again
+        if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
+            if (!split_pressed_) {
+                setViewports(viewports_.empty() ? splitViewports(cameraState()) : std::vector<Viewport>());
+                split_pressed_ = true;
+            }
+        } else {
+            split_pressed_ = false;
+        }
+
+        // Backspace cancels running loads
+        if (glfwGetKey(window, GLFW_KEY_BACKSPACE) == GLFW_PRESS) {
+            if (!cancel_pressed_) {
+                cancelLoads();
+                cancel_pressed_ = true;
+            }
+        } else {
+            cancel_pressed_ = false;
+        }
+
+        // Bird's-eye-view raster: B toggles it (looking straight down), M cycles the channel
+        if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS) {
+            if (!raster_pressed_) {
+                RasterOptions options;
+                bool enable;
+                {
+                    std::lock_guard<std::mutex> lock(data_mutex_);
+                    options = raster_options_;
+                    enable = !raster_mode_;
+                }
+                setRasterMode(enable, options);
+                if (enable) elevation_ = 89.0f;
+                raster_pressed_ = true;
+            }
+        } else {
+            raster_pressed_ = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
+            if (!channel_pressed_) {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                raster_options_.channel = static_cast<RasterChannel>((static_cast<int>(raster_options_.channel) + 1) % 3);
+                channel_pressed_ = true;
+            }
+        } else {
+            channel_pressed_ = false;
+        }
+
         // Grid rotation controls
         if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
             grid_rotation_y_ += rotation_speed;
@@ -1200,51 +7674,512 @@ private:
         return delta;
     }
 
-    // Asynchronous data processing
+    // Asynchronous data processing: up to PIPELINE_MAX_IN_FLIGHT batches pass the pipeline
+    // stages concurrently, and are stored in the order they were taken from the ring
     void processData() {
-        while (is_running_) {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cond_var_.wait(lock, [this]() { return !point_queue_.empty() || !is_running_; });
-
-            while (!point_queue_.empty()) {
-                auto new_points = std::move(point_queue_.front());
-                point_queue_.pop();
-                lock.unlock();
-
-                // Convert Points to separate position and color vectors
-                std::vector<float> positions;
-                std::vector<float> colors;
-                positions.reserve(new_points.size() * 3);
-                colors.reserve(new_points.size() * 3);
-                for (const auto& p : new_points) {
-                    positions.push_back(p.x);
-                    positions.push_back(p.y);
-                    positions.push_back(p.z);
-                    colors.push_back(p.r / 255.0f);
-                    colors.push_back(p.g / 255.0f);
-                    colors.push_back(p.b / 255.0f);
-                }
+        tbb::parallel_pipeline(Config::PIPELINE_MAX_IN_FLIGHT,
+            tbb::make_filter<void, IngestBatch*>(tbb::filter_mode::serial_in_order,
+                [this](tbb::flow_control& control) -> IngestBatch* {
+                    std::unique_ptr<IngestBatch> batch;
+                    while (!popIngestBatch(batch)) {
+                        if (!is_running_) {
+                            control.stop();
+                            return nullptr;
+                        }
+                    }
+                    ingest_space_.notify();
+                    return batch.release();
+                }) &
+            tbb::make_filter<IngestBatch*, IngestBatch*>(tbb::filter_mode::parallel,
+                [this](IngestBatch* batch) {
+                    batch->failed = !BatchPipeline::run(*pipeline_.snapshot(), batch->points);
+                    return batch;
+                }) &
+            tbb::make_filter<IngestBatch*, void>(tbb::filter_mode::serial_in_order,
+                [this](IngestBatch* raw) {
+                    std::unique_ptr<IngestBatch> batch(raw);
+                    // A failed stage or channels of different lengths would make storeBatch
+                    // read past the shorter channels
+                    if (batch->failed || !batch->points.consistent()) {
+                        if (!batch->failed)
+                            std::cerr << "[Error] Dropped a batch whose channels differ in length" << std::endl;
+                        countDroppedBatch(*batch);
+                        return;
+                    }
+                    // Update the main point cloud data; the clock is read and the latency
+                    // recorded outside the lock so they do not lengthen the critical section
+                    auto arrival = std::chrono::steady_clock::now();
+                    {
+                        std::lock_guard<std::mutex> data_lock(data_mutex_);
+                        // The first batch of a cloud (e.g. a progressive LAS load) sets its origin
+                        if (ring_count_ == 0) std::copy(batch->points.origin, batch->points.origin + 3, points_origin_);
+                        storeBatch(batch->points, arrival);
+                        data_updated_ = true;
+                    }
+                    ingestion_latency_.record(std::chrono::steady_clock::now() - batch->enqueued);
+                }));
+    }
 
-                // Update the main point cloud data
-                {
-                    std::lock_guard<std::mutex> data_lock(data_mutex_);
-                    point_cloud_.insert(point_cloud_.end(), positions.begin(), positions.end());
-                    point_colors_.insert(point_colors_.end(), colors.begin(), colors.end());
-                    data_updated_ = true;
+    // Keep a background load or export thread until it finishes; joins those that have
+    void trackLoad(const std::shared_ptr<LoadHandle>& handle, std::thread&& thread) {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        for (auto it = loads_.begin(); it != loads_.end();) {
+            if (it->first->completion().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                it->second.join();
+                it = loads_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        loads_.emplace_back(handle, std::move(thread));
+    }
+
+    // Copy of the stored points in age order. The copy is allocated without data_mutex_ and
+    // filled in slices of SNAPSHOT_SLICE_POINTS, taking the lock for each, so rendering and
+    // ingestion wait for one slice at a time. If the slots change between slices the copy
+    // starts over; after SNAPSHOT_RETRIES restarts it is made under a single lock.
+    PointBuffers snapshotPoints() {
+        PointBuffers points;
+        for (int attempt = 0; ; ++attempt) {
+            bool whole = attempt == Config::SNAPSHOT_RETRIES;
+            std::unique_lock<std::mutex> lock(data_mutex_);
+            uint64_t generation = slots_generation_;
+            auto live = liveRanges();
+            size_t count = ring_count_;
+            std::copy(points_origin_, points_origin_ + 3, points.origin);
+            points.attributes.clear();
+            for (const AttributeChannel& channel : point_attributes_) points.attributes.push_back({ channel.name, channel.type, {} });
+            bool intensity = !point_intensity_.empty(), classification = !point_classification_.empty();
+            if (!whole) lock.unlock();
+            points.resize(count, intensity, classification);
+
+            // Copy the points with age-order indices [begin, end)
+            auto copy = [&](size_t begin, size_t end) {
+                size_t offset = 0;
+                for (const auto& range : live) {
+                    size_t n = range.second - range.first;
+                    size_t first = std::max(begin, offset), last = std::min(end, offset + n);
+                    if (first < last) {
+                        parallelForChunks(last - first, Config::WRITE_CHUNK_POINTS, [&](size_t b, size_t e) {
+                            size_t from = range.first + first - offset + b, to = first + b, count = e - b;
+                            std::copy_n(point_cloud_.begin() + from * 3, count * 3, points.positions.begin() + to * 3);
+                            std::copy_n(point_colors_.begin() + from * 3, count * 3, points.colors.begin() + to * 3);
+                            if (intensity)
+                                std::copy_n(point_intensity_.begin() + from, count, points.intensity.begin() + to);
+                            if (classification)
+                                std::copy_n(point_classification_.begin() + from, count, points.classification.begin() + to);
+                            for (size_t a = 0; a < points.attributes.size(); ++a)
+                                points.attributes[a].copyFrom(point_attributes_[a], from, to, count);
+                        });
+                    }
+                    offset += n;
                 }
+            };
+            if (whole) {
+                copy(0, count);
+                return points;
+            }
+            if (forEachLockedSlice(generation, count, Config::SNAPSHOT_SLICE_POINTS, copy))
+                return points;
+        }
+    }
+
+    // Run fn(begin, end) over [0, count) in slices, taking data_mutex_ for each, as long as
+    // the slots are those of generation; false once ingestion has changed them
+    template <typename Fn>
+    bool forEachLockedSlice(uint64_t generation, size_t count, size_t slice, Fn&& fn) {
+        for (size_t begin = 0; begin < count; begin += slice) {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            if (slots_generation_ != generation) return false;
+            fn(begin, std::min(begin + slice, count));
+        }
+        return true;
+    }
+
+    // Feed merged source batches into the ingestion ring as they become due
+    void publishMergedBatches() {
+        std::vector<PointBuffers> ready;
+        while (merger_.waitReady(ready)) {
+            for (PointBuffers& points : ready)
+                addPoints(std::move(points));
+            ready.clear();
+        }
+    }
 
-                lock.lock();
+    void countDroppedBatch(const IngestBatch& batch) {
+        batches_dropped_.fetch_add(1, std::memory_order_relaxed);
+        points_dropped_.fetch_add(batch.points.size(), std::memory_order_relaxed);
+    }
+
+    size_t slotCount() const {
+        return point_cloud_.size() / 3;
+    }
+
+    // All slots hold displayed points, in age order (after setPoints())
+    void resetRing() {
+        layout_changed_ = true;
+        ++slots_generation_;
+        invalidateRaster();
+        ring_tail_ = 0;
+        ring_count_ = slotCount();
+        batch_spans_.clear();
+        if (ring_count_)
+            batch_spans_.push_back({ ring_count_, std::chrono::steady_clock::now() });
+        cluster_boxes_ = point_cluster_.empty() ? std::vector<ClusterBox>()
+                                                : clusterBoxes(point_cloud_.data(), point_cluster_.data(), ring_count_);
+        cluster_boxes_dirty_ = true;
+        updateColorRange();
+    }
+
+    // Copy count points from src_index of a batch into consecutive slots (or append them)
+    void writeSlots(size_t slot, const PointView& points, size_t src_index, size_t count) {
+        bool append = slot == slotCount();
+        bool fresh = slotCount() == 0;
+        markDirty(slot, count);
+        auto put = [&](auto& dst, const auto* src, size_t width) {
+            if (append) dst.resize(dst.size() + count * width);
+            if (src) std::copy_n(src + src_index * width, count * width, dst.begin() + slot * width);
+            else if (!append) std::fill_n(dst.begin() + slot * width, count * width, 0);
+        };
+        put(point_cloud_, points.positions, 3);
+        put(point_colors_, points.colors, 3);
+        if (!points.colors) {
+            const float* p = points.positions + src_index * 3;
+            float* c = point_colors_.data() + slot * 3;
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t r, g, b;
+                distanceToRGB(p[i * 3], p[i * 3 + 1], p[i * 3 + 2], Config::COLOR_MAX_DISTANCE, r, g, b);
+                c[i * 3 + 0] = r / 255.0f;
+                c[i * 3 + 1] = g / 255.0f;
+                c[i * 3 + 2] = b / 255.0f;
+            }
+        }
+        // Optional channels are kept if the first stored batch carries them
+        if (!point_intensity_.empty() || (fresh && points.intensity))
+            put(point_intensity_, points.intensity, 1);
+        if (!point_classification_.empty() || (fresh && points.classification))
+            put(point_classification_, points.classification, 1);
+        if (!point_cluster_.empty() || (fresh && points.cluster))
+            put(point_cluster_, points.cluster, 1);
+        if (!point_time_.empty()) {
+            // Relative to the timeline base, so float keeps its precision on long recordings
+            const AttributeChannel* time = points.attribute("time");
+            if (append) point_time_.resize(point_time_.size() + count);
+            for (size_t i = 0; i < count; ++i) {
+                float t = time ? static_cast<float>(time->value(src_index + i) - timeline_.base) : timeline_.last;
+                point_time_[slot + i] = t;
+                timeline_.first = std::min(timeline_.first, t);
+                timeline_.last = std::max(timeline_.last, t);
+            }
+        }
+        if (fresh && points.attributes)
+            for (const AttributeChannel& channel : *points.attributes)
+                point_attributes_.push_back({ channel.name, channel.type, {} });
+        for (AttributeChannel& channel : point_attributes_) {
+            const AttributeChannel* src = points.attribute(channel.name, channel.type);
+            put(channel.bytes, src ? src->bytes.data() : nullptr, channel.elementSize());
+        }
+        if (!color_attribute_.empty()) growColorRange(slot, count);
+    }
+
+    // Add (sign = 1) or subtract (sign = -1) stored slots from the raster, or schedule a
+    // rebuild when the grid no longer fits or the max z may be stale
+    void accumulateRaster(size_t first, size_t count, int sign) {
+        if (!raster_mode_) return;
+        if (raster_job_) (sign > 0 ? raster_job_->added : raster_job_->removed) += count;
+        if (raster_.needsRebuild()) return;
+        const float* intensity = point_intensity_.empty() ? nullptr : point_intensity_.data();
+        if (!raster_.accumulate(point_cloud_.data(), intensity, first, first + count, sign) ||
+            raster_.removedSinceRebuild() > ring_count_)
+            raster_.invalidate();
+    }
+
+    // Record slots that changed so only they are uploaded again, and sliced copies start over
+    void markDirty(size_t first, size_t count) {
+        ++slots_generation_;
+        if (!dirty_ranges_.empty() && dirty_ranges_.back().second == first)
+            dirty_ranges_.back().second += count;
+        else
+            dirty_ranges_.emplace_back(first, first + count);
+    }
+
+    // Append a batch at the head of the ring, making room first if the capacity is reached
+    void storeBatch(const PointView& points, std::chrono::steady_clock::time_point time) {
+        size_t count = points.count;
+        size_t skip = 0;
+        if (capacity_.max_points && count > capacity_.max_points) {
+            skip = count - capacity_.max_points; // Only the newest points of the batch fit
+            ingest_stats_.points_evicted += skip;
+            count = capacity_.max_points;
+        }
+        if (count == 0) return;
+        if (capacity_.max_points && ring_count_ + count > capacity_.max_points)
+            makeRoom(ring_count_ + count - capacity_.max_points);
+
+        size_t written = 0;
+        while (written < count) {
+            size_t slots = slotCount();
+            size_t head = ring_tail_ + ring_count_;
+            size_t run;
+            if (head == slots && (capacity_.max_points == 0 || slots < capacity_.max_points)) {
+                // Still growing: append behind the last slot
+                run = count - written;
+                if (capacity_.max_points) run = std::min(run, capacity_.max_points - slots);
+            } else {
+                head %= slots;
+                run = std::min(count - written, slots - head);
+            }
+            writeSlots(head, points, skip + written, run);
+            accumulateRaster(head, run, 1);
+            ring_count_ += run;
+            written += run;
+        }
+        batch_spans_.push_back({ count, time });
+        if (points.cluster) {
+            // The overlay shows the clusters of the newest clustered batch
+            cluster_boxes_ = clusterBoxes(points.positions + skip * 3, points.cluster + skip, count);
+            cluster_boxes_dirty_ = true;
+        }
+    }
+
+    // Free at least needed slots at the old end of the ring according to the eviction policy
+    void makeRoom(size_t needed) {
+        needed = std::min(needed, ring_count_);
+        size_t thin = std::min(std::max(needed, capacity_.max_points / 8), ring_count_ / 2);
+        if (capacity_.eviction == EvictionPolicy::Decimate && thin >= needed && thin > 0) {
+            decimateOldest(thin);
+        } else {
+            ingest_stats_.points_evicted += needed;
+            dropOldest(needed);
+        }
+    }
+
+    // Remove count points from the old end of the ring
+    void dropOldest(size_t count) {
+        size_t slots = slotCount();
+        if (slots == 0 || count == 0) return;
+        for (size_t i = 0; i < count; ) {
+            size_t first = (ring_tail_ + i) % slots;
+            size_t run = std::min(count - i, slots - first);
+            accumulateRaster(first, run, -1);
+            i += run;
+        }
+        ring_tail_ = (ring_tail_ + count) % slots;
+        ring_count_ -= count;
+        ++slots_generation_;
+        while (count > 0 && !batch_spans_.empty()) {
+            BatchSpan& span = batch_spans_.front();
+            size_t n = std::min(count, span.count);
+            span.count -= n;
+            count -= n;
+            if (span.count == 0) batch_spans_.pop_front();
+        }
+        if (ring_count_ == 0) ring_tail_ = 0;
+    }
+
+    // Thin the oldest 2 * count points to every second one, packed against the newer data
+    void decimateOldest(size_t count) {
+        size_t slots = slotCount();
+        auto slot = [&](size_t offset) { return (ring_tail_ + offset) % slots; };
+        // Subtract the 2 * count thinned slots from the raster; the survivors are added back below
+        auto rasterSpan = [&](size_t offset, size_t n, int sign) {
+            for (size_t i = 0; i < n; ) {
+                size_t first = slot(offset + i);
+                size_t run = std::min(n - i, slots - first);
+                accumulateRaster(first, run, sign);
+                i += run;
             }
+        };
+        if (raster_job_) raster_job_->stale = true; // Its copy can no longer be matched to the slots
+        rasterSpan(0, 2 * count, -1);
+        for (size_t k = 0; k < count; ++k) {
+            // Walk from the newer end so no source is overwritten before it is read
+            size_t dst = slot(2 * count - 1 - k);
+            size_t src = slot(2 * count - 1 - 2 * k);
+            if (dst == src) continue;
+            std::copy_n(point_cloud_.begin() + src * 3, 3, point_cloud_.begin() + dst * 3);
+            std::copy_n(point_colors_.begin() + src * 3, 3, point_colors_.begin() + dst * 3);
+            if (!point_intensity_.empty()) point_intensity_[dst] = point_intensity_[src];
+            if (!point_classification_.empty()) point_classification_[dst] = point_classification_[src];
+            if (!point_cluster_.empty()) point_cluster_[dst] = point_cluster_[src];
+            if (!point_time_.empty()) point_time_[dst] = point_time_[src];
+            for (AttributeChannel& channel : point_attributes_) channel.copyFrom(channel, src, dst, 1);
+        }
+
+        // The thinned points take the age of the newest span they came from
+        std::chrono::steady_clock::time_point newest = batch_spans_.front().time;
+        size_t remaining = 2 * count;
+        while (remaining > 0 && !batch_spans_.empty()) {
+            BatchSpan& span = batch_spans_.front();
+            size_t n = std::min(remaining, span.count);
+            newest = span.time;
+            span.count -= n;
+            remaining -= n;
+            if (span.count == 0) batch_spans_.pop_front();
         }
+        batch_spans_.push_front({ count, newest });
+        rasterSpan(count, count, 1);
+        size_t first = slot(count);
+        size_t run = std::min(count, slots - first);
+        markDirty(first, run);
+        if (run < count) markDirty(0, count - run);
+        ring_tail_ = first;
+        ring_count_ -= count;
+        ingest_stats_.points_decimated += count;
+    }
+
+    // Drop points older than max_age; returns true if anything changed
+    bool expirePoints(std::chrono::steady_clock::time_point now) {
+        if (capacity_.max_age.count() == 0) return false;
+        bool changed = false;
+        while (!batch_spans_.empty() && now - batch_spans_.front().time > capacity_.max_age) {
+            size_t count = batch_spans_.front().count;
+            ingest_stats_.points_expired += count;
+            dropOldest(count);
+            changed = true;
+        }
+        // An unbounded cloud never wraps, so reclaim the expired prefix once it dominates
+        if (changed && capacity_.max_points == 0 && ring_tail_ > slotCount() / 2)
+            linearizeStorage();
+        return changed;
+    }
+
+    // Move the displayed points to slots [0, ring_count_) in age order and release the rest
+    void linearizeStorage() {
+        size_t slots = slotCount();
+        if (ring_tail_ == 0 && ring_count_ == slots) return;
+        auto linearize = [&](auto& data, size_t width) {
+            if (data.empty()) return;
+            std::remove_reference_t<decltype(data)> out;
+            out.reserve(ring_count_ * width);
+            for (size_t i = 0; i < ring_count_; ) {
+                size_t s = (ring_tail_ + i) % slots;
+                size_t run = std::min(ring_count_ - i, slots - s);
+                out.insert(out.end(), data.begin() + s * width, data.begin() + (s + run) * width);
+                i += run;
+            }
+            data.swap(out);
+        };
+        linearize(point_cloud_, 3);
+        linearize(point_colors_, 3);
+        linearize(point_intensity_, 1);
+        linearize(point_classification_, 1);
+        linearize(point_cluster_, 1);
+        linearize(point_time_, 1);
+        for (AttributeChannel& channel : point_attributes_) linearize(channel.bytes, channel.elementSize());
+        ring_tail_ = 0;
+        layout_changed_ = true;
+        ++slots_generation_;
     }
 
+    // Read frames from the shared-memory ring in place: each frame is copied once, straight
+    // into the slot storage the GPU chunks upload from, then handed back to the producer.
+    // Frames without colours are coloured before data_mutex_ is taken, and the lock is held
+    // for one frame at a time so the render thread never waits for more than one copy.
+    void consumeSharedMemory() {
+        ShmRingConsumer ring;
+        std::vector<float> colors; // Distance colours of the current frame
+        int idle = 0;
+        while (is_running_) {
+            if (!ring.isOpen()) {
+                if (!ring.open(shm_name_)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(Config::SHM_POLL_INTERVAL_MS));
+                    continue;
+                }
+                std::cout << "[Info] Attached to shared memory " << shm_name_ << std::endl;
+            }
+
+            ShmFrameView frame;
+            if (!ring.peek(frame)) {
+                if (!ring.isOpen()) { // Malformed frame: detached, attach again later
+                    std::this_thread::sleep_for(std::chrono::milliseconds(Config::SHM_POLL_INTERVAL_MS));
+                    continue;
+                }
+                if (++idle < Config::INGEST_SPIN_ITERATIONS) {
+                    std::this_thread::yield();
+                } else if (ring.isClosed()) {
+                    ring.close();
+                    std::cout << "[Info] Shared memory producer closed, waiting for a new one" << std::endl;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                continue;
+            }
+            idle = 0;
+
+            PointView view;
+            view.positions = frame.positions;
+            view.colors = frame.colors;
+            view.intensity = frame.intensity;
+            view.count = frame.point_count;
+            if (!view.colors) {
+                colors.resize(view.count * 3);
+                parallelForChunks(view.count, Config::WRITE_CHUNK_POINTS, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        const float* p = view.positions + i * 3;
+                        uint8_t r, g, b;
+                        distanceToRGB(p[0], p[1], p[2], Config::COLOR_MAX_DISTANCE, r, g, b);
+                        colors[i * 3 + 0] = r / 255.0f;
+                        colors[i * 3 + 1] = g / 255.0f;
+                        colors[i * 3 + 2] = b / 255.0f;
+                    }
+                });
+                view.colors = colors.data();
+            }
+            auto now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> data_lock(data_mutex_);
+                storeBatch(view, now);
+                data_updated_ = true;
+            }
+            ring.release(frame);
+        }
+    }
 
+    // Take the next batch: spin briefly for low latency, then sleep until signalled.
+    // Returns false when woken without a batch (e.g. on shutdown).
+    bool popIngestBatch(std::unique_ptr<IngestBatch>& batch) {
+        for (int i = 0; i < Config::INGEST_SPIN_ITERATIONS; ++i) {
+            if (ingest_queue_.tryPop(batch)) return true;
+            std::this_thread::yield();
+        }
+        uint64_t key = ingest_ready_.prepareWait();
+        if (ingest_queue_.tryPop(batch)) {
+            ingest_ready_.cancelWait();
+            return true;
+        }
+        if (!is_running_) {
+            ingest_ready_.cancelWait();
+            return false;
+        }
+        ingest_ready_.wait(key);
+        return ingest_queue_.tryPop(batch);
+    }
 
     // Cleanup resources
     void cleanup() {
-        if (vbo_) glDeleteBuffers(1, &vbo_);
-        if (color_vbo_) glDeleteBuffers(1, &color_vbo_);
-        if (vao_) glDeleteVertexArrays(1, &vao_);
+        // Loader threads feed the ingest queue, so they stop first
+        cancelLoads();
+        {
+            std::lock_guard<std::mutex> lock(load_mutex_);
+            for (auto& load : loads_) load.second.join();
+            loads_.clear();
+        }
+        // Finish a running capture while the context still exists, and let it write out
+        recorder_.finish();
+        recorder_.wait();
+        trace_.close();
+        if (offscreen_fbo_) glDeleteFramebuffers(1, &offscreen_fbo_);
+        if (offscreen_color_) glDeleteRenderbuffers(1, &offscreen_color_);
+        if (offscreen_depth_) glDeleteRenderbuffers(1, &offscreen_depth_);
+
+        // Tile buffers need the context, so they go before the window
+        if (tiled_cloud_) tiled_cloud_->releaseGL();
+        tiled_cloud_.reset();
+        pending_tiles_.reset();
+
+        for (auto& chunk : chunks_) releaseChunk(*chunk);
+        chunks_.clear();
         if (shader_program_) glDeleteProgram(shader_program_);
 
         // Cleanup Grid
@@ -1257,6 +8192,16 @@ private:
         if (axes_vao_) glDeleteVertexArrays(1, &axes_vao_);
         if (axes_shader_program_) glDeleteProgram(axes_shader_program_);
 
+        // Cleanup Cluster Boxes
+        if (cluster_vbo_) glDeleteBuffers(1, &cluster_vbo_);
+        if (cluster_vao_) glDeleteVertexArrays(1, &cluster_vao_);
+
+        // Cleanup Raster
+        releaseRasterTexture();
+        if (raster_vbo_) glDeleteBuffers(1, &raster_vbo_);
+        if (raster_vao_) glDeleteVertexArrays(1, &raster_vao_);
+        if (raster_shader_program_) glDeleteProgram(raster_shader_program_);
+
         if (window_) glfwDestroyWindow(window_);
         glfwTerminate();
     }
@@ -0,0 +1,398 @@
+/*
+ * SharedPointRing - Shared-memory point ingestion for CloudPeek
+ *
+ * A single-producer/single-consumer ring buffer in a POSIX shared-memory object
+ * (shm_open). An external process (the producer) writes point frames into the ring
+ * and a PointCloudViewer started with openSharedMemory() (or `--shm <name>`) reads
+ * them in place. There are no sockets and no serialization: the producer fills the
+ * frame directly in shared memory and the viewer copies it straight into its GPU
+ * staging storage.
+ *
+ * This header only depends on the C++ standard library and POSIX, so producers can
+ * include it without OpenGL.
+ *
+ * @section Layout
+ * The object starts with a 4096-byte ShmRingHeader followed by data_bytes of frame
+ * area. write_pos and read_pos are monotonic byte counters into the frame area; a
+ * frame starts at (pos % data_bytes) and never wraps: when it does not fit before the
+ * end, the producer first writes a padding frame covering the rest of the area.
+ *
+ *   ShmRingHeader (4096 bytes)
+ *     0   char     magic[8]        "CPSHMRNG"
+ *     8   uint32   version         SHM_RING_VERSION
+ *     12  uint32   header_bytes    4096
+ *     16  uint64   data_bytes      Size of the frame area (multiple of 64)
+ *     24  uint32   producer_state  0 = starting, 1 = running, 2 = closed
+ *     28  uint32   producer_pid
+ *     64  uint64   write_pos       Bytes published by the producer (atomic, own cache line)
+ *     128 uint64   read_pos        Bytes released by the consumer (atomic, own cache line)
+ *     192 uint64   frames_written
+ *     200 uint64   frames_dropped  Frames the producer gave up on because the ring was full
+ *
+ *   Frame (64-byte aligned, frame_bytes long)
+ *     0   uint32   magic           SHM_FRAME_MAGIC
+ *     4   uint32   flags           SHM_FRAME_COLORS | SHM_FRAME_INTENSITY | SHM_FRAME_PADDING
+ *     8   uint64   frame_bytes     Header and payload, rounded up to 64 bytes
+ *     16  uint64   sequence        Frame number
+ *     24  uint64   point_count
+ *     32  uint64   timestamp_ns    Producer clock, informational
+ *     64  float32  positions[3 * point_count]   x, y, z
+ *         float32  colors[3 * point_count]      r, g, b in 0..1, if SHM_FRAME_COLORS
+ *         float32  intensity[point_count]       if SHM_FRAME_INTENSITY
+ *
+ * Frames without colors are coloured by distance in the viewer.
+ *
+ * Example producer:
+ *   ShmRingProducer producer;
+ *   producer.create("/cloudpeek", 256 << 20);
+ *   ShmFrameView frame;
+ *   if (producer.beginFrame(count, SHM_FRAME_COLORS, frame)) {
+ *       fill(frame.positions, frame.colors, count);
+ *       producer.commitFrame(frame);
+ *   }
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ==========================
+// Shared Layout
+// ==========================
+
+constexpr char SHM_RING_MAGIC[8] = { 'C', 'P', 'S', 'H', 'M', 'R', 'N', 'G' };
+constexpr uint32_t SHM_RING_VERSION = 1;
+constexpr uint32_t SHM_FRAME_MAGIC = 0x52465043; // "CPFR"
+
+constexpr uint32_t SHM_FRAME_COLORS = 1u << 0;
+constexpr uint32_t SHM_FRAME_INTENSITY = 1u << 1;
+constexpr uint32_t SHM_FRAME_PADDING = 1u << 31;
+
+enum ShmProducerState : uint32_t {
+    SHM_PRODUCER_STARTING = 0,
+    SHM_PRODUCER_RUNNING = 1,
+    SHM_PRODUCER_CLOSED = 2
+};
+
+struct ShmRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    uint64_t data_bytes;
+    std::atomic<uint32_t> producer_state;
+    uint32_t producer_pid;
+    alignas(64) std::atomic<uint64_t> write_pos;
+    alignas(64) std::atomic<uint64_t> read_pos;
+    alignas(64) std::atomic<uint64_t> frames_written;
+    std::atomic<uint64_t> frames_dropped;
+    uint8_t reserved[4096 - 208];
+};
+static_assert(sizeof(ShmRingHeader) == 4096, "ShmRingHeader layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared-memory counters must be lock-free");
+
+struct ShmFrameHeader {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t frame_bytes;
+    uint64_t sequence;
+    uint64_t point_count;
+    uint64_t timestamp_ns;
+    uint64_t reserved[3];
+};
+static_assert(sizeof(ShmFrameHeader) == 64, "ShmFrameHeader layout");
+
+inline uint64_t shmFrameBytes(uint64_t point_count, uint32_t flags) {
+    uint64_t floats = point_count * 3;
+    if (flags & SHM_FRAME_COLORS) floats += point_count * 3;
+    if (flags & SHM_FRAME_INTENSITY) floats += point_count;
+    return (sizeof(ShmFrameHeader) + floats * sizeof(float) + 63) & ~uint64_t{63};
+}
+
+// Pointers into one frame of the ring (null for absent channels)
+struct ShmFrameView {
+    ShmFrameHeader* header = nullptr;
+    float* positions = nullptr;
+    float* colors = nullptr;
+    float* intensity = nullptr;
+    size_t point_count = 0;
+};
+
+inline ShmFrameView shmFrameView(ShmFrameHeader* header) {
+    ShmFrameView view;
+    view.header = header;
+    view.point_count = header->point_count;
+    float* p = reinterpret_cast<float*>(header + 1);
+    view.positions = p;
+    p += view.point_count * 3;
+    if (header->flags & SHM_FRAME_COLORS) {
+        view.colors = p;
+        p += view.point_count * 3;
+    }
+    if (header->flags & SHM_FRAME_INTENSITY)
+        view.intensity = p;
+    return view;
+}
+
+// Maps a shared-memory object; base class of the producer and consumer ends
+class ShmRingMapping {
+public:
+    ShmRingMapping() = default;
+    ShmRingMapping(const ShmRingMapping&) = delete;
+    ShmRingMapping& operator=(const ShmRingMapping&) = delete;
+    ~ShmRingMapping() { unmap(); }
+
+    bool isOpen() const { return header_ != nullptr; }
+    ShmRingHeader* header() const { return header_; }
+
+protected:
+    bool map(int fd, size_t bytes) {
+        void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) return false;
+        header_ = static_cast<ShmRingHeader*>(addr);
+        data_ = static_cast<uint8_t*>(addr) + sizeof(ShmRingHeader);
+        map_bytes_ = bytes;
+        return true;
+    }
+
+    void unmap() {
+        if (header_) munmap(header_, map_bytes_);
+        header_ = nullptr;
+        data_ = nullptr;
+        map_bytes_ = 0;
+    }
+
+    ShmFrameHeader* frameAt(uint64_t pos) const {
+        return reinterpret_cast<ShmFrameHeader*>(data_ + pos % header_->data_bytes);
+    }
+
+    ShmRingHeader* header_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t map_bytes_ = 0;
+};
+
+// ==========================
+// Producer
+// ==========================
+
+class ShmRingProducer : public ShmRingMapping {
+public:
+    ~ShmRingProducer() { close(); }
+
+    // Create (or replace) the shared-memory object with a frame area of data_bytes
+    bool create(const std::string& name, size_t data_bytes) {
+        close();
+        data_bytes = (data_bytes + 63) & ~size_t{63};
+        shm_unlink(name.c_str()); // Start from a clean ring
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0) {
+            std::cerr << "Error: Could not create shared memory " << name << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        size_t bytes = sizeof(ShmRingHeader) + data_bytes;
+        bool ok = ftruncate(fd, static_cast<off_t>(bytes)) == 0 && map(fd, bytes);
+        ::close(fd);
+        if (!ok) {
+            std::cerr << "Error: Could not map shared memory " << name << "\n";
+            shm_unlink(name.c_str());
+            return false;
+        }
+        name_ = name;
+
+        std::memcpy(header_->magic, SHM_RING_MAGIC, sizeof(SHM_RING_MAGIC));
+        header_->version = SHM_RING_VERSION;
+        header_->header_bytes = sizeof(ShmRingHeader);
+        header_->data_bytes = data_bytes;
+        header_->producer_pid = static_cast<uint32_t>(getpid());
+        header_->write_pos.store(0, std::memory_order_relaxed);
+        header_->read_pos.store(0, std::memory_order_relaxed);
+        header_->frames_written.store(0, std::memory_order_relaxed);
+        header_->frames_dropped.store(0, std::memory_order_relaxed);
+        header_->producer_state.store(SHM_PRODUCER_RUNNING, std::memory_order_release);
+        return true;
+    }
+
+    // Mark the ring closed (the consumer drains it and waits for a new producer) and unlink it
+    void close() {
+        if (!header_) return;
+        header_->producer_state.store(SHM_PRODUCER_CLOSED, std::memory_order_release);
+        unmap();
+        shm_unlink(name_.c_str());
+        name_.clear();
+    }
+
+    // Reserve a frame for point_count points. If the ring is full the call waits up to
+    // max_wait for the consumer to make room (zero drops the frame immediately); a frame
+    // that does not get room is counted in frames_dropped and false is returned.
+    bool beginFrame(size_t point_count, uint32_t flags, ShmFrameView& frame,
+                    std::chrono::microseconds max_wait = std::chrono::microseconds::max()) {
+        if (!header_) return false;
+        uint64_t bytes = shmFrameBytes(point_count, flags);
+        uint64_t capacity = header_->data_bytes;
+        if (bytes > capacity / 2) {
+            std::cerr << "Error: Frame of " << point_count << " points exceeds half the shared ring\n";
+            return false;
+        }
+
+        uint64_t write = header_->write_pos.load(std::memory_order_relaxed);
+        uint64_t offset = write % capacity;
+        uint64_t padding = offset + bytes > capacity ? capacity - offset : 0;
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (max_wait < std::chrono::microseconds::max())
+            deadline = std::chrono::steady_clock::now() + max_wait;
+        for (int spin = 0; !hasSpace(write, padding + bytes); ++spin) {
+            if (max_wait.count() == 0 || (spin > 64 && std::chrono::steady_clock::now() >= deadline)) {
+                header_->frames_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (spin > 64) std::this_thread::yield();
+        }
+
+        // Frames never wrap: cover the tail of the area with a padding frame
+        if (padding) {
+            ShmFrameHeader* pad = frameAt(write);
+            pad->magic = SHM_FRAME_MAGIC;
+            pad->flags = SHM_FRAME_PADDING;
+            pad->frame_bytes = padding;
+            pad->point_count = 0;
+            write += padding;
+            header_->write_pos.store(write, std::memory_order_release);
+        }
+
+        ShmFrameHeader* header = frameAt(write);
+        header->magic = SHM_FRAME_MAGIC;
+        header->flags = flags & (SHM_FRAME_COLORS | SHM_FRAME_INTENSITY);
+        header->frame_bytes = bytes;
+        header->sequence = sequence_;
+        header->point_count = point_count;
+        header->timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        frame = shmFrameView(header);
+        return true;
+    }
+
+    // Publish a frame filled after beginFrame()
+    void commitFrame(const ShmFrameView& frame) {
+        uint64_t write = header_->write_pos.load(std::memory_order_relaxed);
+        header_->write_pos.store(write + frame.header->frame_bytes, std::memory_order_release);
+        header_->frames_written.fetch_add(1, std::memory_order_relaxed);
+        ++sequence_;
+    }
+
+    // Copy a frame from existing arrays (colors and intensity may be null)
+    bool publish(const float* positions, const float* colors, const float* intensity, size_t point_count,
+                 std::chrono::microseconds max_wait = std::chrono::microseconds::max()) {
+        uint32_t flags = (colors ? SHM_FRAME_COLORS : 0) | (intensity ? SHM_FRAME_INTENSITY : 0);
+        ShmFrameView frame;
+        if (!beginFrame(point_count, flags, frame, max_wait)) return false;
+        std::memcpy(frame.positions, positions, point_count * 3 * sizeof(float));
+        if (colors) std::memcpy(frame.colors, colors, point_count * 3 * sizeof(float));
+        if (intensity) std::memcpy(frame.intensity, intensity, point_count * sizeof(float));
+        commitFrame(frame);
+        return true;
+    }
+
+private:
+    bool hasSpace(uint64_t write, uint64_t bytes) const {
+        uint64_t read = header_->read_pos.load(std::memory_order_acquire);
+        return header_->data_bytes - (write - read) >= bytes;
+    }
+
+    std::string name_;
+    uint64_t sequence_ = 0;
+};
+
+// ==========================
+// Consumer
+// ==========================
+
+class ShmRingConsumer : public ShmRingMapping {
+public:
+    // Attach to a ring created by a producer; false if it does not exist (yet)
+    bool open(const std::string& name) {
+        unmap();
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > sizeof(ShmRingHeader) &&
+                  map(fd, static_cast<size_t>(st.st_size));
+        ::close(fd);
+        if (!ok) return false;
+        if (std::memcmp(header_->magic, SHM_RING_MAGIC, sizeof(SHM_RING_MAGIC)) != 0 ||
+            header_->version != SHM_RING_VERSION ||
+            header_->producer_state.load(std::memory_order_acquire) == SHM_PRODUCER_STARTING ||
+            header_->data_bytes == 0 || header_->data_bytes % 64 != 0 ||
+            sizeof(ShmRingHeader) + header_->data_bytes > map_bytes_) {
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    void close() { unmap(); }
+
+    // The oldest unread frame, in place; false if the ring is empty. The producer is not
+    // trusted: if a frame header does not describe a valid frame inside the published part
+    // of the ring, the next frame boundary is unknown, so everything published so far is
+    // dropped and the consumer detaches (isOpen() turns false).
+    bool peek(ShmFrameView& frame) {
+        uint64_t write = header_->write_pos.load(std::memory_order_acquire);
+        uint64_t read = header_->read_pos.load(std::memory_order_relaxed);
+        while (read != write) {
+            ShmFrameHeader* header = frameAt(read);
+            if (!isValidFrame(header, read, write)) {
+                std::cerr << "Error: Malformed frame in shared memory at byte " << read << ", detaching\n";
+                header_->read_pos.store(write, std::memory_order_release);
+                unmap();
+                return false;
+            }
+            if (!(header->flags & SHM_FRAME_PADDING)) {
+                frame = shmFrameView(header);
+                return true;
+            }
+            read += header->frame_bytes;
+            header_->read_pos.store(read, std::memory_order_release);
+        }
+        return false;
+    }
+
+    // Give the frame returned by peek() back to the producer
+    void release(const ShmFrameView& frame) {
+        uint64_t read = header_->read_pos.load(std::memory_order_relaxed);
+        header_->read_pos.store(read + frame.header->frame_bytes, std::memory_order_release);
+    }
+
+    // frame_bytes must be a non-zero multiple of 64 that ends inside the frame area and the
+    // published bytes, and large enough for the points and channels the header announces
+    bool isValidFrame(const ShmFrameHeader* header, uint64_t read, uint64_t write) const {
+        uint64_t capacity = header_->data_bytes;
+        uint64_t bytes = header->frame_bytes;
+        if (header->magic != SHM_FRAME_MAGIC || bytes == 0 || bytes % 64 != 0 ||
+            bytes > write - read || read % capacity + bytes > capacity)
+            return false;
+        if (header->flags & SHM_FRAME_PADDING) return true;
+        // Bound point_count first so shmFrameBytes() cannot overflow
+        return header->point_count <= capacity / (3 * sizeof(float)) &&
+               shmFrameBytes(header->point_count, header->flags) <= bytes;
+    }
+
+    // The producer closed the ring (or exited without closing it) and everything in it
+    // has been read
+    bool isClosed() const {
+        bool closed = header_->producer_state.load(std::memory_order_acquire) == SHM_PRODUCER_CLOSED ||
+                      (kill(static_cast<pid_t>(header_->producer_pid), 0) != 0 && errno == ESRCH);
+        return closed &&
+               header_->read_pos.load(std::memory_order_relaxed) == header_->write_pos.load(std::memory_order_acquire);
+    }
+};
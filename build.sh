@@ -1 +1,2 @@
- g++ main.cpp -o point_cloud_viewer -lglfw -lGLEW -lGL -pthread -ltbb -std=c++17
\ No newline at end of file
+ g++ main.cpp -o point_cloud_viewer -lglfw -lGLEW -lGL -pthread -ltbb -std=c++17
+ g++ shm_producer.cpp -o shm_producer -O2 -pthread -lrt -std=c++17
@@ -9,6 +9,23 @@
  *  - Parallel computation for performance optimization
  *  - Batch-wise streaming of events to the viewer for real-time visualization
  *  - Coloring of points based on event polarity
+ *  - Loading of PCD, binary PLY, LAS and raw KITTI velodyne scans (.bin file or a whole drive directory)
+ *  - Conversion of PCD files to an out-of-core tile format (.cpt) that is streamed from disk
+ *  - Live points from another process through a shared-memory ring (--shm <name>, see shm_producer.cpp)
+ *  - Event timelines uploaded once and scrubbed in the shader (<csv_file> <window_ms> --timeline)
+ *  - Conversion of CSV events to a compact binary format (.cpev) that replays from a memory
+ *    mapping and seeks through a block index (<file.cpev> <window_ms> --start <ms>)
+ *  - Recording of the rendered frames to PNG, raw RGBA or an encoder pipe, optionally
+ *    headless with an orbiting camera (--record <target> --frames N --orbit <deg/s> --headless)
+ *  - Recording of all viewer input to a trace (--trace <file>) and its replay at the recorded
+ *    pace or as fast as possible, reporting frame times (--replay <file> [--max-speed] [--headless])
+ *  - Progressive, cancellable loading of point clouds that shows chunks as they are decoded
+ *    (<file> --progressive, Backspace cancels)
+ *  - Change detection between two scans, colouring each point by its distance to the
+ *    reference cloud (<file> --compare <reference> [--threshold <m>] [--max-change <m>])
+ *  - Real-time event playback under a per-frame budget: bursts are decimated per pixel
+ *    (latest wins) or randomly, keeping the polarity ratio (--event-budget <n> --decimate latest|random)
+ *  - Ground segmentation of loaded and streamed points, hidden with G (--ground)
  * 
  * Key components:
  *  - PointCloudViewer: A single-header viewer that handles rendering the point cloud.
@@ -32,14 +49,125 @@
 #include <fstream>
 #include <sstream>
 #include <functional> // For std::ref and std::cref
+#include <future>
 #include <tbb/tbb.h>
 
 
-// Function to load events from a CSV file and stream them to the viewer
-// The CSV is expected to contain: x,y,polarity,timestamp
-inline void loadEventsAsyncToViewer(const std::string& filename,
-                                   PointCloudViewer& viewer,
-                                   int time_window_ms) {
+// Function to load a point cloud file and hand it to the viewer in one piece. stage (if set)
+// processes the whole cloud first, as the viewer's pipeline does for streamed batches.
+inline void loadCloudAsyncToViewer(const std::string& path, PointCloudViewer& viewer, const PointStage& stage) {
+    auto start = std::chrono::steady_clock::now();
+
+    PointBuffers buffers;
+    bool cache_hit = false;
+    std::future<bool> cache_write; // A cold load writes the cache while the viewer shows the points
+    if (!readPointCloudCached(path, buffers, &cache_hit, &cache_write))
+        return;
+    if (stage) stage(buffers);
+    viewer.setPoints(std::move(buffers));
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << "[Info] Loaded " << path << " in " << elapsed.count() << " ms ("
+              << (cache_hit ? "warm, from cache" : "cold") << ")\n";
+    if (cache_write.valid()) cache_write.wait();
+}
+
+
+// Function to load a point cloud progressively: chunks appear as they are decoded and
+// Backspace in the viewer cancels the load. Prints the progress twice a second.
+inline void loadCloudProgressivelyToViewer(const std::string& path, PointCloudViewer& viewer) {
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<LoadHandle> load = viewer.loadAsync(path);
+    std::shared_future<bool> done = load->completion();
+    while (done.wait_for(std::chrono::milliseconds(500)) != std::future_status::ready) {
+        std::cout << "[Info] Loading " << path << ": " << static_cast<int>(load->progress() * 100.0f) << "%, "
+                  << load->pointsLoaded() << " points" << std::endl;
+    }
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << "[Info] " << (done.get() ? "Loaded " : (load->isCancelled() ? "Cancelled loading " : "Failed to load "))
+              << path << " after " << elapsed.count() << " ms (" << load->pointsLoaded() << " points)\n";
+}
+
+// Function to load two clouds and show the first coloured by its distance to the reference.
+// Both files are read concurrently; compared points stream into the viewer chunk by chunk.
+inline void compareCloudsToViewer(const std::string& path, const std::string& reference_path,
+                                  const ChangeOptions& options, PointCloudViewer& viewer) {
+    auto start = std::chrono::steady_clock::now();
+    PointBuffers reference, compared;
+    auto reference_read = std::async(std::launch::async, [&] { return readPointCloudCached(reference_path, reference); });
+    bool ok = readPointCloudCached(path, compared);
+    if (!reference_read.get() || !ok)
+        return;
+    auto loaded = std::chrono::steady_clock::now();
+
+    // The loader starts before the viewer loop; give it a moment to come up
+    for (int i = 0; i < 1000 && !viewer.isRunning(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    ChangeStats stats = detectChanges(reference, compared, options, [&](PointBuffers&& chunk) {
+        if (viewer.isRunning()) viewer.addPoints(std::move(chunk));
+    });
+    std::cout << "[Info] Compared " << stats.points << " points against " << reference.size() << " reference points: "
+              << stats.changed << " changed by at least " << options.threshold << " m (load "
+              << std::chrono::duration<double>(loaded - start).count() << " s, index " << stats.index_seconds
+              << " s, compare " << stats.compare_seconds << " s)\n";
+}
+
+// Colour of an event by polarity (0 -> blue, 1 -> red)
+inline void eventColor(int polarity, float rgb[3]) {
+    rgb[0] = polarity ? 1.0f : 0.0f;
+    rgb[1] = 0.0f;
+    rgb[2] = polarity ? 0.0f : 1.0f;
+}
+
+// Decode a whole binary event file into timeline buffers; blocks decode in parallel
+inline bool readEventFileTimeline(const std::string& filename, PointBuffers& events, std::vector<float>& timestamps,
+                                  double& time_base) {
+    EventFile file;
+    if (!file.open(filename))
+        return false;
+    std::vector<size_t> first(file.blockCount() + 1, 0);
+    for (size_t b = 0; b < file.blockCount(); ++b)
+        first[b + 1] = first[b] + file.block(b).count;
+    events.resize(first.back(), false);
+    timestamps.resize(first.back());
+
+    int64_t t0 = file.header().time_first;
+    time_base = static_cast<double>(t0);
+    parallelForChunks(file.blockCount(), 1, [&](size_t b, size_t) {
+        size_t i = first[b];
+        file.forEachEvent(b, [&](uint32_t x, uint32_t y, uint32_t polarity, int64_t t) {
+            events.positions[i * 3 + 0] = x / 100.0f;
+            events.positions[i * 3 + 1] = y / 100.0f;
+            events.positions[i * 3 + 2] = 0.0f;
+            eventColor(polarity, &events.colors[i * 3]);
+            timestamps[i] = static_cast<float>(t - t0);
+            ++i;
+        });
+    });
+    return true;
+}
+
+// Function to load a whole event recording (CSV or binary) and upload it once as a timeline.
+// The time window then moves in the shader (Space plays/pauses, [ and ] scrub).
+inline void loadEventTimelineToViewer(const std::string& filename,
+                                      PointCloudViewer& viewer,
+                                      int time_window_ms) {
+    PointBuffers events;
+    std::vector<float> timestamps;
+    if (fileExtension(filename) == ".cpev") {
+        double time_base = 0.0;
+        if (!readEventFileTimeline(filename, events, timestamps, time_base))
+            return;
+        size_t count = timestamps.size();
+        float duration = count ? timestamps.back() : 0.0f;
+        viewer.setEventTimeline(std::move(events), std::move(timestamps), time_base);
+        viewer.setTimeWindow(0.0f, static_cast<float>(time_window_ms), time_window_ms / 3.0f);
+        std::cout << "[Info] Uploaded " << count << " events spanning " << duration << " ms as a timeline\n";
+        return;
+    }
+
     std::ifstream file(filename);
     if (!file) {
         std::cerr << "Failed to open CSV file: " << filename << '\n';
@@ -51,58 +179,311 @@ inline void loadEventsAsyncToViewer(const std::string& filename,
     if (!std::getline(file, line))
         return;
 
-    struct TimedPoint { Point pt; int ts; };
-    std::deque<TimedPoint> window_points;
-
-    int prev_t = -1;
-
-    while (std::getline(file, line) && viewer.isRunning()) {
+    int first_t = -1;
+    while (std::getline(file, line)) {
         std::istringstream ss(line);
         int x = 0, y = 0, p = 0, t = 0;
         char comma;
         if (!(ss >> x >> comma >> y >> comma >> p >> comma >> t)) {
             continue; // Skip malformed line
         }
+        if (first_t < 0) first_t = t;
 
+        float rgb[3];
+        eventColor(p, rgb);
+        events.positions.insert(events.positions.end(), { x / 100.0f, y / 100.0f, 0.0f });
+        events.colors.insert(events.colors.end(), rgb, rgb + 3);
+        timestamps.push_back(static_cast<float>(t - first_t)); // Milliseconds since the first event
+    }
+
+    size_t count = timestamps.size();
+    float duration = count ? timestamps.back() : 0.0f;
+    viewer.setEventTimeline(std::move(events), std::move(timestamps), std::max(first_t, 0));
+    viewer.setTimeWindow(0.0f, static_cast<float>(time_window_ms), time_window_ms / 3.0f);
+    std::cout << "[Info] Uploaded " << count << " events spanning " << duration << " ms as a timeline\n";
+}
 
-        // Sleep according to timestamp difference to simulate real-time
-        if (prev_t >= 0 && t > prev_t) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(t - prev_t));
+
+// Real-time event display under a budget. Events are grouped into display frames of
+// recording time, each frame is decimated to the budget (see EventDecimator) and the viewer
+// gets one update per frame with the events of the last time_window_ms. Shown and dropped
+// counts are printed once a second.
+class EventWindowPlayer {
+public:
+    EventWindowPlayer(PointCloudViewer& viewer, int time_window_ms, const EventDecimationOptions& options)
+        : viewer_(viewer), time_window_ms_(time_window_ms), decimator_(options) {}
+
+    // Events arrive in time order, timestamps in milliseconds
+    void push(uint32_t x, uint32_t y, uint32_t polarity, int64_t t) {
+        if (frame_end_ == INT64_MIN) {
+            first_t_ = t;
+            frame_end_ = t + frame_ms_;
+            wall_start_ = std::chrono::steady_clock::now();
+            last_report_ = wall_start_;
+        }
+        if (t >= frame_end_) {
+            showFrame();
+            frame_end_ += ((t - frame_end_) / frame_ms_ + 1) * frame_ms_; // Skip empty frames
         }
-        prev_t = t;
+        frame_.push_back({ x, y, polarity, t });
+    }
+
+    // Show the last partial frame and print the totals
+    void finish() {
+        if (!frame_.empty()) showFrame();
+        const EventDecimationStats& stats = decimator_.stats();
+        std::cout << "[Info] Events: " << stats.shown << " shown, " << stats.dropped << " dropped of "
+                  << stats.received << " (" << stats.decimated_frames << " of " << stats.frames
+                  << " frames over budget)" << std::endl;
+    }
 
-        Point pt;
-        pt.x = static_cast<float>(x / 100.0);
-        pt.y = static_cast<float>(y / 100.0);
-        pt.z = static_cast<float>(0.0); // Assuming z is always 0 for 2D events
+private:
+    void showFrame() {
+        // Wait until the frame has passed in real time; a reader that fell behind does not wait
+        auto due = wall_start_ + std::chrono::milliseconds(frame_end_ - first_t_);
+        std::this_thread::sleep_until(due);
 
-        if (p == 0) {          // polarity 0 -> blue
-            pt.r = 0; pt.g = 0; pt.b = 255;
-        } else {               // polarity 1 -> red
-            pt.r = 255; pt.g = 0; pt.b = 0;
+        decimator_.decimate(frame_);
+        for (const EventRecord& e : frame_) {
+            Point pt;
+            pt.x = e.x / 100.0f;
+            pt.y = e.y / 100.0f;
+            pt.z = 0.0f; // Events are 2D
+            float rgb[3];
+            eventColor(e.polarity, rgb);
+            pt.r = static_cast<uint8_t>(rgb[0] * 255);
+            pt.g = static_cast<uint8_t>(rgb[1] * 255);
+            pt.b = static_cast<uint8_t>(rgb[2] * 255);
+            window_points_.push_back({ pt, e.t });
         }
+        frame_.clear();
+        while (!window_points_.empty() && frame_end_ - window_points_.front().ts > time_window_ms_)
+            window_points_.pop_front();
+
+        current_points_.assign(window_points_.size(), Point());
+        std::transform(window_points_.begin(), window_points_.end(), current_points_.begin(),
+                       [](const TimedPoint& wp) { return wp.pt; });
+        viewer_.setPoints(current_points_);
 
-        // Add new event and remove expired ones
-        window_points.push_back({pt, t});
-        while (!window_points.empty() &&
-               (t - window_points.front().ts > time_window_ms)) {
-            window_points.pop_front();
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report_ >= std::chrono::seconds(1)) {
+            const EventDecimationStats& stats = decimator_.stats();
+            std::cout << "[Info] Events: " << stats.shown << " shown, " << stats.dropped << " dropped, "
+                      << std::chrono::duration<double, std::milli>(now - due).count() << " ms behind real time"
+                      << std::endl;
+            last_report_ = now;
         }
+    }
+
+    struct TimedPoint { Point pt; int64_t ts; };
+
+    PointCloudViewer& viewer_;
+    int64_t time_window_ms_;
+    int64_t frame_ms_ = std::max(1000 / Config::EVENT_DISPLAY_FPS, 1);
+    EventDecimator decimator_;
+    std::vector<EventRecord> frame_;
+    std::deque<TimedPoint> window_points_;
+    std::vector<Point> current_points_;
+    int64_t first_t_ = 0, frame_end_ = INT64_MIN;
+    std::chrono::steady_clock::time_point wall_start_, last_report_;
+};
 
-        // Convert window points to vector for the viewer
-        std::vector<Point> current_points;
-        current_points.reserve(window_points.size());
-        for (const auto& wp : window_points) {
-            current_points.push_back(wp.pt);
+
+// Function to replay a binary event file from its memory mapping. Seeking to start_ms
+// (relative to the first event) is a lookup in the block index.
+inline void loadEventFileAsyncToViewer(const std::string& filename,
+                                       PointCloudViewer& viewer,
+                                       int time_window_ms,
+                                       int64_t start_ms,
+                                       EventDecimationOptions decimation) {
+    EventFile file;
+    if (!file.open(filename))
+        return;
+
+    // The loader starts before the viewer loop; give it a moment to come up
+    for (int i = 0; i < 1000 && !viewer.isRunning(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    EventWindowPlayer player(viewer, time_window_ms, decimation);
+    int64_t start_t = file.header().time_first + start_ms;
+    for (size_t b = file.findBlock(start_t); b < file.blockCount() && viewer.isRunning(); ++b) {
+        file.forEachEvent(b, [&](uint32_t x, uint32_t y, uint32_t polarity, int64_t t) {
+            if (t >= start_t) player.push(x, y, polarity, t);
+        });
+    }
+    player.finish();
+}
+
+
+// Function to load events from a CSV file and stream them to the viewer
+// The CSV is expected to contain: x,y,polarity,timestamp
+inline void loadEventsAsyncToViewer(const std::string& filename,
+                                   PointCloudViewer& viewer,
+                                   int time_window_ms,
+                                   EventDecimationOptions decimation) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Failed to open CSV file: " << filename << '\n';
+        return;
+    }
+
+    std::string line;
+    // Skip header if present
+    if (!std::getline(file, line))
+        return;
+
+    EventWindowPlayer player(viewer, time_window_ms, decimation);
+    while (std::getline(file, line) && viewer.isRunning()) {
+        const char* p = line.data();
+        const char* end = p + line.size();
+        int64_t x, y, polarity, t;
+        if (!parseEventField(p, end, x) || !parseEventField(p, end, y) ||
+            !parseEventField(p, end, polarity) || !parseEventField(p, end, t) || x < 0 || y < 0) {
+            continue; // Skip malformed line
         }
+        player.push(static_cast<uint32_t>(x), static_cast<uint32_t>(y), polarity != 0, t);
+    }
+    player.finish();
+}
 
-        viewer.setPoints(current_points);
+// Re-drive the viewer from a recorded trace (see TraceRecorder), at the recorded pace or as
+// fast as possible, and report the frame times. A headless viewer stops after the replay.
+inline void replayTraceToViewer(const std::string& filename, PointCloudViewer& viewer, bool max_speed, bool stop_when_done) {
+    TraceReader reader;
+    if (!reader.open(filename)) {
+        if (stop_when_done) viewer.stop();
+        return;
     }
 
+    // The replay starts before the viewer loop; give it a moment to come up
+    for (int i = 0; i < 1000 && !viewer.isRunning(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto start = std::chrono::steady_clock::now();
+    TraceEvent event;
+    size_t calls = 0, points = 0;
+    while (viewer.isRunning() && reader.next(event)) {
+        if (!max_speed) std::this_thread::sleep_until(start + event.time);
+        switch (event.type) {
+            case TraceEventType::AddPoints:
+                points += event.points.size();
+                viewer.addPoints(std::move(event.points), event.backpressure);
+                break;
+            case TraceEventType::SetPoints:
+                points += event.points.size();
+                viewer.setPoints(std::move(event.points));
+                break;
+            case TraceEventType::ClearPoints:
+                viewer.clearPoints();
+                break;
+            case TraceEventType::Camera:
+                viewer.setCamera(event.camera);
+                break;
+        }
+        ++calls;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    LatencyHistogram::Snapshot frames = viewer.frameTimes();
+    LatencyHistogram::Snapshot latency = viewer.ingestionLatency();
+    std::cout << "[Info] Replayed " << calls << " calls (" << points << " points) in " << elapsed.count() << " s\n"
+              << "[Info] Frame time: " << frames.count << " frames, mean " << frames.mean_us / 1000.0
+              << " ms, p50 <= " << frames.percentileUs(0.5) / 1000.0 << " ms, p99 <= " << frames.percentileUs(0.99) / 1000.0
+              << " ms, max " << frames.max_us / 1000.0 << " ms\n"
+              << "[Info] Ingestion latency: p99 <= " << latency.percentileUs(0.99) / 1000.0 << " ms, max "
+              << latency.max_us / 1000.0 << " ms" << std::endl;
+    if (stop_when_done) viewer.stop();
 }
 
 
 int main(int argc, char* argv[]) {
+    // Capture options may appear anywhere: --record <target> [--frames N] [--orbit <deg/s>] [--headless]
+    // A target starting with '|' is a command that receives raw RGBA frames on stdin,
+    // .rgba/.raw appends raw frames to one file, .png is a single image, anything else a directory of frame_NNNNNN.png.
+    // Input traces: --trace <file> records this session, --replay <file> [--max-speed] replays one
+    // --progressive shows a point cloud chunk by chunk while it loads (bypassing the point cache)
+    // --compare <reference> [--threshold <m>] [--max-change <m>] colours a cloud by its distance to a reference
+    // --event-budget <n> caps the events shown per display frame (0 shows all), --decimate latest|random
+    // --ground labels ground points (RANSAC per batch or loaded cloud) so G can hide them
+    CaptureOptions capture;
+    float orbit_speed = 0.0f;
+    bool headless = false;
+    std::string trace_filename, replay_filename;
+    bool max_speed = false;
+    bool progressive = false;
+    std::string reference_filename;
+    ChangeOptions change;
+    EventDecimationOptions decimation;
+    PointStage ground_stage;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) {
+            capture.output = argv[++i];
+            if (capture.output[0] == '|') {
+                capture.format = CaptureFormat::Pipe;
+                capture.output.erase(0, 1);
+            } else if (fileExtension(capture.output) == ".rgba" || fileExtension(capture.output) == ".raw") {
+                capture.format = CaptureFormat::Raw;
+            }
+        } else if (arg == "--frames" && i + 1 < argc) {
+            capture.max_frames = std::stoul(argv[++i]);
+        } else if (arg == "--orbit" && i + 1 < argc) {
+            orbit_speed = std::stof(argv[++i]);
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_filename = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_filename = argv[++i];
+        } else if (arg == "--max-speed") {
+            max_speed = true;
+        } else if (arg == "--progressive") {
+            progressive = true;
+        } else if (arg == "--compare" && i + 1 < argc) {
+            reference_filename = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            change.threshold = std::stof(argv[++i]);
+        } else if (arg == "--max-change" && i + 1 < argc) {
+            change.max_distance = std::stof(argv[++i]);
+        } else if (arg == "--event-budget" && i + 1 < argc) {
+            decimation.frame_budget = std::stoul(argv[++i]);
+        } else if (arg == "--decimate" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "latest") {
+                decimation.mode = EventDecimation::LatestPerPixel;
+            } else if (mode == "random") {
+                decimation.mode = EventDecimation::Random;
+            } else {
+                std::cerr << "[Error] --decimate must be latest or random, not " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--ground") {
+            ground_stage = groundSegmentationStage();
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (headless && replay_filename.empty() && (capture.output.empty() || capture.max_frames == 0)) {
+        std::cerr << "[Error] --headless needs --replay <trace>, or --record <target> and --frames <count>" << std::endl;
+        return 1;
+    }
+    argc = static_cast<int>(args.size());
+    argv = args.data();
+
+    // Offline conversion to the out-of-core tile format: --build-tiles <input.pcd> <output.cpt>
+    if (argc > 3 && std::string(argv[1]) == "--build-tiles") {
+        return buildTilesFromPCD(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // Offline conversion of a CSV event recording: --convert-events <input.csv> <output.cpev>
+    if (argc > 3 && std::string(argv[1]) == "--convert-events") {
+        return convertEventsCSV(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // Live points from an external producer process: --shm <name>
+    bool shared_memory = argc > 2 && std::string(argv[1]) == "--shm";
+
     // Set default CSV file path
     std::string csv_filename = "data/csv/events.csv";
 
@@ -114,18 +495,46 @@ int main(int argc, char* argv[]) {
     }
 
     // Initialize viewer with predefined configuration parameters
-    PointCloudViewer viewer(Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT, Config::WINDOW_TITLE);
+    PointCloudViewer viewer(Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT, Config::WINDOW_TITLE, headless);
+    if (!capture.output.empty()) viewer.startRecording(capture);
+    viewer.setAutoRotate(orbit_speed);
+    if (ground_stage) viewer.addPipelineStage("ground", ground_stage);
+    if (!trace_filename.empty() && viewer.startTrace(trace_filename))
+        std::cout << "[Info] Recording input trace to " << trace_filename << std::endl;
 
     std::cout << "[Info] Hold the middle mouse button and drag to rotate when the cursor is free." << std::endl;
     std::cout << "[Info] Right-click and drag to pan the point cloud." << std::endl;
 
     int time_window_ms = 100; // default time window
-    if (argc > 2) {
+    if (argc > 2 && !shared_memory) {
         time_window_ms = std::stoi(argv[2]);
     }
 
-    // Launch async thread to load and stream CSV events to the viewer
-    std::thread loader_thread(loadEventsAsyncToViewer, csv_filename, std::ref(viewer), time_window_ms);
+    // Launch async thread to load the cloud, or to load and stream CSV events to the viewer
+    std::thread loader_thread;
+    if (!replay_filename.empty()) {
+        loader_thread = std::thread(replayTraceToViewer, replay_filename, std::ref(viewer), max_speed, headless);
+    } else if (shared_memory) {
+        CapacityOptions capacity;
+        capacity.max_points = Config::SHM_CAPACITY_POINTS; // A live feed must not grow without bound
+        viewer.setCapacity(capacity);
+        viewer.openSharedMemory(argv[2]);
+    } else if (fileExtension(csv_filename) == ".cpt") {
+        viewer.openTiles(csv_filename); // Streams from disk while rendering, no loader needed
+    } else if (isPointCloudPath(csv_filename) && !reference_filename.empty()) {
+        loader_thread = std::thread(compareCloudsToViewer, csv_filename, reference_filename, change, std::ref(viewer));
+    } else if (isPointCloudPath(csv_filename) && progressive) {
+        loader_thread = std::thread(loadCloudProgressivelyToViewer, csv_filename, std::ref(viewer));
+    } else if (isPointCloudPath(csv_filename)) {
+        loader_thread = std::thread(loadCloudAsyncToViewer, csv_filename, std::ref(viewer), ground_stage);
+    } else if (argc > 3 && std::string(argv[3]) == "--timeline") {
+        loader_thread = std::thread(loadEventTimelineToViewer, csv_filename, std::ref(viewer), time_window_ms);
+    } else if (fileExtension(csv_filename) == ".cpev") {
+        int64_t start_ms = argc > 4 && std::string(argv[3]) == "--start" ? std::stoll(argv[4]) : 0;
+        loader_thread = std::thread(loadEventFileAsyncToViewer, csv_filename, std::ref(viewer), time_window_ms, start_ms, decimation);
+    } else {
+        loader_thread = std::thread(loadEventsAsyncToViewer, csv_filename, std::ref(viewer), time_window_ms, decimation);
+    }
 
     // Execute the main viewer loop (blocks until viewer window is closed)
     viewer.run();
@@ -0,0 +1,118 @@
+/*
+ * CloudPeek shared-memory test producer
+ *
+ * Streams synthetic scans into a shared-memory ring (SharedPointRing.hpp) that a viewer
+ * started with `--shm <name>` consumes. Each frame is written in place in shared memory,
+ * so the only copy on the producer side is filling the frame itself.
+ *
+ * Usage:
+ *   ./shm_producer <name> [points_per_frame] [seconds] [--colors]
+ *   ./shm_producer <name> --drain [seconds]     Null consumer, measures ring throughput
+ *
+ * Both modes print the sustained points per second once a second.
+ */
+
+#include "SharedPointRing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Precomputed rotating sweep: frames copy a slice of it so the producer cost is the copy
+static std::vector<float> makeSweep(size_t points) {
+    std::vector<float> sweep(points * 3);
+    for (size_t i = 0; i < points; ++i) {
+        float angle = static_cast<float>(i) * 0.0007f;
+        float range = 5.0f + 40.0f * static_cast<float>((i * 2654435761u) % 1000) / 1000.0f;
+        sweep[i * 3 + 0] = range * std::cos(angle);
+        sweep[i * 3 + 1] = range * std::sin(angle);
+        sweep[i * 3 + 2] = -1.7f + 0.1f * static_cast<float>(i % 64);
+    }
+    return sweep;
+}
+
+static void reportRate(const char* what, uint64_t& points, std::chrono::steady_clock::time_point& last) {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last).count();
+    if (seconds < 1.0) return;
+    std::cout << "[Info] " << what << " " << static_cast<double>(points) / seconds / 1e6 << " M points/s" << std::endl;
+    points = 0;
+    last = now;
+}
+
+static int produce(const std::string& name, size_t points_per_frame, double seconds, bool colors) {
+    ShmRingProducer producer;
+    if (!producer.create(name, size_t(512) << 20)) return 1;
+
+    const size_t sweep_points = points_per_frame * 16;
+    std::vector<float> sweep = makeSweep(sweep_points);
+    std::vector<float> sweep_colors(colors ? sweep_points * 3 : 0, 0.8f);
+
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    uint64_t points = 0, total = 0;
+    size_t offset = 0;
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+        // Wait a while for a slow (or absent) viewer, then drop the frame and move on
+        ShmFrameView frame;
+        if (!producer.beginFrame(points_per_frame, colors ? SHM_FRAME_COLORS : 0, frame,
+                                 std::chrono::milliseconds(100)))
+            continue;
+        std::copy_n(sweep.data() + offset * 3, points_per_frame * 3, frame.positions);
+        if (colors) std::copy_n(sweep_colors.data() + offset * 3, points_per_frame * 3, frame.colors);
+        producer.commitFrame(frame);
+        offset = (offset + points_per_frame) % sweep_points;
+        points += points_per_frame;
+        total += points_per_frame;
+        reportRate("Produced", points, last);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[Info] Produced " << total << " points, average " << total / elapsed / 1e6 << " M points/s, "
+              << producer.header()->frames_dropped.load() << " frames dropped" << std::endl;
+    return 0;
+}
+
+static int drain(const std::string& name, double seconds) {
+    ShmRingConsumer consumer;
+    while (!consumer.open(name))
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    uint64_t points = 0;
+    std::vector<float> scratch;
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+        ShmFrameView frame;
+        if (!consumer.peek(frame)) {
+            if (consumer.isClosed()) break;
+            std::this_thread::yield();
+            continue;
+        }
+        // Copy the frame out like the viewer does into its slot storage
+        scratch.resize(frame.point_count * 3);
+        std::copy_n(frame.positions, frame.point_count * 3, scratch.data());
+        points += frame.point_count;
+        consumer.release(frame);
+        reportRate("Consumed", points, last);
+    }
+    std::cout << "[Info] Drain finished" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <name> [points_per_frame] [seconds] [--colors]\n"
+                  << "       " << argv[0] << " <name> --drain [seconds]\n";
+        return 1;
+    }
+    std::string name = argv[1];
+    if (argc > 2 && std::string(argv[2]) == "--drain")
+        return drain(name, argc > 3 ? std::stod(argv[3]) : 10.0);
+
+    size_t points_per_frame = argc > 2 ? std::stoul(argv[2]) : 65536;
+    double seconds = argc > 3 ? std::stod(argv[3]) : 10.0;
+    bool colors = argc > 4 && std::string(argv[4]) == "--colors";
+    return produce(name, points_per_frame, seconds, colors);
+}